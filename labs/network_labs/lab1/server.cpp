@@ -1,202 +1,623 @@
-#include <arpa/inet.h>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <fstream>
-#include <iostream>
-#include <netinet/in.h>
-#include <sstream>
-#include <string>
-#include <sys/socket.h>
-#include <unistd.h>
-
-const int BUFFER_SIZE = 1024;
-
-// 分类文件
-std::string getMimeType(const std::string &fileExtension)
-{
-	if (fileExtension == "html") {
-		return "text/html";
-	} else if (fileExtension == "css") {
-		return "text/css";
-	} else if (fileExtension == "js") {
-		return "application/javascript";
-	} else {
-		return "application/octet-stream";
-	}
-}
-
-// 读取文件
-std::string readFile(const std::string &filename)
-{
-	std::ifstream file(filename, std::ios::in | std::ios::binary);
-	if (!file) {
-		return "";
-	}
-
-	std::ostringstream content;
-	content << file.rdbuf();
-	return content.str();
-}
-
-// 处理客户端请求
-void handleRequest(int clientSocket, const std::string &rootDirectory)
-{
-	// 获取客户端地址信息
-	struct sockaddr_in clientAddr;
-	socklen_t addrLen = sizeof(clientAddr);
-	getpeername(clientSocket, (struct sockaddr *)&clientAddr, &addrLen);
-	char clientIP[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &(clientAddr.sin_addr), clientIP, INET_ADDRSTRLEN);
-	int clientPort = ntohs(clientAddr.sin_port);
-
-	char buffer[BUFFER_SIZE];
-	memset(buffer, 0, sizeof(buffer));
-	int bytesRead = recv(clientSocket, buffer, sizeof(buffer), 0);
-
-	if (bytesRead <= 0) {
-		close(clientSocket);
-		return;
-	}
-
-	std::istringstream request(buffer);
-	std::string requestLine;
-	getline(request, requestLine);
-	std::istringstream requestLineStream(requestLine);
-	std::string method, path, httpVersion;
-	requestLineStream >> method >> path >> httpVersion;
-
-	if (method != "GET") {
-		// 输出错误信息
-		std::cerr << "Received invalid request from " << clientIP << ":"
-			  << clientPort << " - " << requestLine << std::endl;
-		close(clientSocket);
-		return;
-	}
-
-	std::string filename = rootDirectory + path;
-
-	if (filename == rootDirectory + "/") {
-		filename = rootDirectory + "/index.html";
-	}
-
-	std::string fileExtension =
-		filename.substr(filename.find_last_of(".") + 1);
-	std::string mimeType = getMimeType(fileExtension);
-
-	std::string fileContent = readFile(filename);
-	if (fileContent.empty()) {
-		// 文件不存在，尝试读取webroot/error.html
-		filename = rootDirectory + "/error.html";
-		fileContent = readFile(filename);
-
-		if (fileContent.empty()) {
-			// 如果error.html文件也不存在，输出文件未找到信息
-			std::cerr << "Requested file not found for " << clientIP
-				  << ":" << clientPort << " - " << requestLine
-				  << std::endl;
-			close(clientSocket);
-			return;
-		}
-
-		// 如果error.html文件存在，更新MIME类型
-		fileExtension = "html";
-		mimeType = "text/html";
-	}
-
-	// 输出请求来源信息
-	std::cout << "Received request from " << clientIP << ":" << clientPort
-		  << " - " << requestLine << std::endl;
-
-	// 构建HTTP响应
-	std::ostringstream response;
-	response << "HTTP/1.1 200 OK\r\n"
-		 << "Content-Type: " << mimeType << "\r\n"
-		 << "Content-Length: " << fileContent.size() << "\r\n"
-		 << "\r\n"
-		 << fileContent;
-
-	// 发送HTTP响应
-	send(clientSocket, response.str().c_str(), response.str().size(), 0);
-
-	// 输出请求处理完成信息
-	std::cout << "Sent response to " << clientIP << ":" << clientPort
-		  << " - " << requestLine << std::endl;
-
-	close(clientSocket);
-}
-
-int main(int argc, char *argv[])
-{
-	if (argc != 3) {
-		std::cerr << "Usage: " << argv[0] << " <port> <root_directory>"
-			  << std::endl;
-		return 1;
-	}
-
-	int PORT = std::atoi(argv[1]);
-	std::string rootDirectory = argv[2];
-
-	int serverSocket, clientSocket;
-	struct sockaddr_in serverAddr, clientAddr;
-	socklen_t addrLen = sizeof(clientAddr);
-
-	// 创建套接字
-	serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-	if (serverSocket == -1) {
-		perror("Socket creation failed");
-		exit(EXIT_FAILURE);
-	}
-
-	// 设置地址重用
-	int reuse = 1;
-	if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse,
-		       sizeof(int)) == -1) {
-		perror("Socket option failed");
-		exit(EXIT_FAILURE);
-	}
-
-	// 配置服务器地址结构
-	serverAddr.sin_family = AF_INET;
-	serverAddr.sin_port = htons(PORT);
-	serverAddr.sin_addr.s_addr = INADDR_ANY;
-
-	// 绑定套接字到地址
-	if (bind(serverSocket, (struct sockaddr *)&serverAddr,
-		 sizeof(serverAddr)) == -1) {
-		perror("Binding failed");
-		exit(EXIT_FAILURE);
-	}
-
-	// 开始监听客户端连接
-	if (listen(serverSocket, 5) == -1) {
-		perror("Listening failed");
-		exit(EXIT_FAILURE);
-	}
-
-	std::cout << "Server is running on port " << PORT
-		  << " with root directory " << rootDirectory << std::endl;
-
-	while (1) {
-		// 接受客户端连接
-		clientSocket = accept(serverSocket,
-				      (struct sockaddr *)&clientAddr, &addrLen);
-		if (clientSocket == -1) {
-			perror("Accepting client connection failed");
-			continue;
-		}
-
-		// 创建子进程处理客户端请求
-		if (fork() == 0) {
-			// 子进程
-			close(serverSocket); // 关闭父进程的套接字副本
-			handleRequest(clientSocket, rootDirectory);
-			exit(0);
-		}
-
-		close(clientSocket); // 父进程关闭客户端套接字
-	}
-
-	close(serverSocket);
-	return 0;
-}
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <linux/mempolicy.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "timer_wheel.h"
+
+const int BUFFER_SIZE = 1024;
+const int MAX_HEADER_SIZE = 8192;
+const int MAX_EVENTS = 256;
+const int MAX_NUMA_NODES = 64;
+
+// 时间轮的精度以及各类超时（毫秒）
+const int TICK_MS = 100;
+const int IDLE_TIMEOUT_MS = 15000; // keep-alive连接两次请求之间的空闲时间
+const int HEADER_TIMEOUT_MS = 10000; // 从收到请求第一个字节到读完请求头
+const int WRITE_TIMEOUT_MS = 30000; // 响应发送没有任何进展的时间
+
+enum ConnState {
+	CONN_IDLE, // 等待下一个请求
+	CONN_READING, // 正在读取请求头
+	CONN_WRITING // 正在发送响应
+};
+
+struct Connection {
+	int fd;
+	char clientIP[INET_ADDRSTRLEN];
+	int clientPort;
+	ConnState state;
+	bool keepAlive;
+	std::string input; // 尚未处理的请求数据
+	std::string output; // 待发送的响应
+	size_t sent;
+	std::string requestLine;
+	bool watchingOut; // 是否在epoll中关注可写事件
+	TimerNode timer; // 当前状态对应的超时
+};
+
+struct EventLoop {
+	int epfd;
+	int serverSocket;
+	std::string rootDirectory;
+	TimerWheel wheel;
+
+	EventLoop(uint64_t now)
+		: wheel(now)
+	{
+	}
+};
+
+// 单调时钟下的当前tick
+uint64_t nowTicks()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000) / TICK_MS;
+}
+
+uint64_t msToTicks(int ms)
+{
+	return (ms + TICK_MS - 1) / TICK_MS;
+}
+
+// 分类文件
+std::string getMimeType(const std::string &fileExtension)
+{
+	if (fileExtension == "html") {
+		return "text/html";
+	} else if (fileExtension == "css") {
+		return "text/css";
+	} else if (fileExtension == "js") {
+		return "application/javascript";
+	} else {
+		return "application/octet-stream";
+	}
+}
+
+// 读取文件
+std::string readFile(const std::string &filename)
+{
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file) {
+		return "";
+	}
+
+	std::ostringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+std::string toLower(std::string s)
+{
+	for (size_t i = 0; i < s.size(); i++) {
+		s[i] = tolower((unsigned char)s[i]);
+	}
+	return s;
+}
+
+// 根据HTTP版本和Connection头决定是否保持连接
+bool wantsKeepAlive(std::istringstream &request, const std::string &httpVersion)
+{
+	bool keepAlive = (httpVersion == "HTTP/1.1");
+	std::string line;
+	while (getline(request, line) && line != "\r" && !line.empty()) {
+		size_t colon = line.find(':');
+		if (colon == std::string::npos ||
+		    toLower(line.substr(0, colon)) != "connection") {
+			continue;
+		}
+		std::string value = toLower(line.substr(colon + 1));
+		if (value.find("close") != std::string::npos) {
+			keepAlive = false;
+		} else if (value.find("keep-alive") != std::string::npos) {
+			keepAlive = true;
+		}
+	}
+	return keepAlive;
+}
+
+// 处理一个完整的请求头，生成响应；返回false表示应直接关闭连接
+bool handleRequest(Connection *conn, const std::string &header,
+		   const std::string &rootDirectory)
+{
+	std::istringstream request(header);
+	std::string requestLine;
+	getline(request, requestLine);
+	if (!requestLine.empty() && requestLine.back() == '\r') {
+		requestLine.pop_back();
+	}
+	std::istringstream requestLineStream(requestLine);
+	std::string method, path, httpVersion;
+	requestLineStream >> method >> path >> httpVersion;
+
+	if (method != "GET") {
+		// 输出错误信息
+		std::cerr << "Received invalid request from " << conn->clientIP
+			  << ":" << conn->clientPort << " - " << requestLine
+			  << std::endl;
+		return false;
+	}
+
+	std::string filename = rootDirectory + path;
+
+	if (filename == rootDirectory + "/") {
+		filename = rootDirectory + "/index.html";
+	}
+
+	std::string fileExtension =
+		filename.substr(filename.find_last_of(".") + 1);
+	std::string mimeType = getMimeType(fileExtension);
+
+	std::string fileContent = readFile(filename);
+	if (fileContent.empty()) {
+		// 文件不存在，尝试读取webroot/error.html
+		filename = rootDirectory + "/error.html";
+		fileContent = readFile(filename);
+
+		if (fileContent.empty()) {
+			// 如果error.html文件也不存在，输出文件未找到信息
+			std::cerr << "Requested file not found for "
+				  << conn->clientIP << ":" << conn->clientPort
+				  << " - " << requestLine << std::endl;
+			return false;
+		}
+
+		// 如果error.html文件存在，更新MIME类型
+		fileExtension = "html";
+		mimeType = "text/html";
+	}
+
+	// 输出请求来源信息
+	std::cout << "Received request from " << conn->clientIP << ":"
+		  << conn->clientPort << " - " << requestLine << std::endl;
+
+	conn->keepAlive = wantsKeepAlive(request, httpVersion);
+	conn->requestLine = requestLine;
+
+	// 构建HTTP响应
+	std::ostringstream response;
+	response << "HTTP/1.1 200 OK\r\n"
+		 << "Content-Type: " << mimeType << "\r\n"
+		 << "Content-Length: " << fileContent.size() << "\r\n"
+		 << "Connection: " << (conn->keepAlive ? "keep-alive" : "close")
+		 << "\r\n"
+		 << "\r\n"
+		 << fileContent;
+	conn->output = response.str();
+	conn->sent = 0;
+	return true;
+}
+
+void setNonBlocking(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void armTimer(EventLoop &loop, Connection *conn, int timeoutMs)
+{
+	loop.wheel.add(&conn->timer, msToTicks(timeoutMs));
+}
+
+void watchWritable(EventLoop &loop, Connection *conn, bool writable)
+{
+	if (conn->watchingOut == writable) {
+		return;
+	}
+	conn->watchingOut = writable;
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	if (writable) {
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.ptr = conn;
+	epoll_ctl(loop.epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+}
+
+void closeConnection(EventLoop &loop, Connection *conn)
+{
+	loop.wheel.cancel(&conn->timer);
+	close(conn->fd); // close会自动从epoll中移除
+	delete conn;
+}
+
+bool processInput(EventLoop &loop, Connection *conn);
+
+// 尽量发送响应，发送完毕后根据keep-alive决定是否继续等待请求
+bool handleWrite(EventLoop &loop, Connection *conn)
+{
+	while (conn->sent < conn->output.size()) {
+		ssize_t n = send(conn->fd, conn->output.data() + conn->sent,
+				 conn->output.size() - conn->sent, MSG_NOSIGNAL);
+		if (n > 0) {
+			conn->sent += n;
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			// 发送缓冲区已满，每次有进展都重新计时
+			armTimer(loop, conn, WRITE_TIMEOUT_MS);
+			watchWritable(loop, conn, true);
+			return true;
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		return false;
+	}
+
+	// 输出请求处理完成信息
+	std::cout << "Sent response to " << conn->clientIP << ":"
+		  << conn->clientPort << " - " << conn->requestLine
+		  << std::endl;
+
+	if (!conn->keepAlive) {
+		return false;
+	}
+	watchWritable(loop, conn, false);
+	conn->state = CONN_IDLE;
+	conn->output.clear();
+	conn->sent = 0;
+	armTimer(loop, conn, IDLE_TIMEOUT_MS);
+	// 客户端可能已经流水线发送了下一个请求
+	return processInput(loop, conn);
+}
+
+// 检查缓冲区中是否已有完整的请求头
+bool processInput(EventLoop &loop, Connection *conn)
+{
+	if (conn->input.empty()) {
+		return true;
+	}
+	if (conn->state == CONN_IDLE) {
+		// 请求头超时从第一个字节开始计算，之后不再重置，防止慢速攻击
+		conn->state = CONN_READING;
+		armTimer(loop, conn, HEADER_TIMEOUT_MS);
+	}
+	size_t end = conn->input.find("\r\n\r\n");
+	if (end == std::string::npos) {
+		return conn->input.size() <= (size_t)MAX_HEADER_SIZE;
+	}
+
+	std::string header = conn->input.substr(0, end + 4);
+	conn->input.erase(0, end + 4);
+	if (!handleRequest(conn, header, loop.rootDirectory)) {
+		return false;
+	}
+	conn->state = CONN_WRITING;
+	loop.wheel.cancel(&conn->timer);
+	return handleWrite(loop, conn);
+}
+
+bool handleRead(EventLoop &loop, Connection *conn)
+{
+	char buffer[BUFFER_SIZE];
+	while (1) {
+		ssize_t n = recv(conn->fd, buffer, sizeof(buffer), 0);
+		if (n > 0) {
+			conn->input.append(buffer, n);
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		return false; // 对方关闭或出错
+	}
+	if (conn->state == CONN_WRITING) {
+		// 上一个响应还没发完，先缓存下一个请求
+		return conn->input.size() <= (size_t)MAX_HEADER_SIZE;
+	}
+	return processInput(loop, conn);
+}
+
+void acceptConnections(EventLoop &loop)
+{
+	while (1) {
+		struct sockaddr_in clientAddr;
+		socklen_t addrLen = sizeof(clientAddr);
+		int clientSocket = accept(loop.serverSocket,
+					  (struct sockaddr *)&clientAddr,
+					  &addrLen);
+		if (clientSocket == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK &&
+			    errno != EINTR) {
+				perror("Accepting client connection failed");
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+		setNonBlocking(clientSocket);
+
+		Connection *conn = new Connection();
+		conn->fd = clientSocket;
+		inet_ntop(AF_INET, &(clientAddr.sin_addr), conn->clientIP,
+			  INET_ADDRSTRLEN);
+		conn->clientPort = ntohs(clientAddr.sin_port);
+		conn->state = CONN_IDLE;
+		conn->keepAlive = false;
+		conn->sent = 0;
+		conn->watchingOut = false;
+		conn->timer.data = conn;
+
+		struct epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.ptr = conn;
+		if (epoll_ctl(loop.epfd, EPOLL_CTL_ADD, clientSocket, &ev) ==
+		    -1) {
+			perror("Epoll add failed");
+			close(clientSocket);
+			delete conn;
+			continue;
+		}
+		armTimer(loop, conn, IDLE_TIMEOUT_MS);
+	}
+}
+
+void runEventLoop(EventLoop &loop)
+{
+	struct epoll_event events[MAX_EVENTS];
+	while (1) {
+		// 没有定时器时无限等待，否则最多睡到下一个tick
+		int timeout = loop.wheel.empty() ? -1 : TICK_MS;
+		int n = epoll_wait(loop.epfd, events, MAX_EVENTS, timeout);
+		if (n == -1 && errno != EINTR) {
+			perror("Epoll wait failed");
+			return;
+		}
+		// 无限等待期间时间轮没有推进，先对齐到当前tick再为新连接计时
+		loop.wheel.sync(nowTicks());
+
+		for (int i = 0; i < n; i++) {
+			if (events[i].data.ptr == nullptr) {
+				acceptConnections(loop);
+				continue;
+			}
+			Connection *conn = (Connection *)events[i].data.ptr;
+			bool alive = true;
+			if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+				alive = false;
+			} else {
+				if (alive && (events[i].events & EPOLLOUT) &&
+				    conn->state == CONN_WRITING) {
+					alive = handleWrite(loop, conn);
+				}
+				if (alive && (events[i].events & EPOLLIN)) {
+					alive = handleRead(loop, conn);
+				}
+			}
+			if (!alive) {
+				closeConnection(loop, conn);
+			}
+		}
+
+		// 到期的连接直接关闭，空闲连接在这之前不产生任何开销
+		loop.wheel.advance(nowTicks(), [&](TimerNode *node) {
+			Connection *conn = (Connection *)node->data;
+			if (conn->state != CONN_IDLE) {
+				std::cerr << "Connection timed out for "
+					  << conn->clientIP << ":"
+					  << conn->clientPort << std::endl;
+			}
+			closeConnection(loop, conn);
+		});
+	}
+}
+
+// 创建监听套接字；多个worker各自监听同一端口，由内核在它们之间分配连接
+int createListener(int port, int cpu)
+{
+	int serverSocket;
+	struct sockaddr_in serverAddr;
+
+	// 创建套接字
+	serverSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (serverSocket == -1) {
+		perror("Socket creation failed");
+		exit(EXIT_FAILURE);
+	}
+
+	// 设置地址重用
+	int reuse = 1;
+	if (setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &reuse,
+		       sizeof(int)) == -1 ||
+	    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEPORT, &reuse,
+		       sizeof(int)) == -1) {
+		perror("Socket option failed");
+		exit(EXIT_FAILURE);
+	}
+
+	// 让内核把在该核上收包的连接交给这个监听套接字
+	if (cpu >= 0 && setsockopt(serverSocket, SOL_SOCKET, SO_INCOMING_CPU,
+				   &cpu, sizeof(int)) == -1) {
+		perror("SO_INCOMING_CPU failed");
+	}
+
+	// 配置服务器地址结构
+	serverAddr.sin_family = AF_INET;
+	serverAddr.sin_port = htons(port);
+	serverAddr.sin_addr.s_addr = INADDR_ANY;
+
+	// 绑定套接字到地址
+	if (bind(serverSocket, (struct sockaddr *)&serverAddr,
+		 sizeof(serverAddr)) == -1) {
+		perror("Binding failed");
+		exit(EXIT_FAILURE);
+	}
+
+	// 开始监听客户端连接
+	if (listen(serverSocket, SOMAXCONN) == -1) {
+		perror("Listening failed");
+		exit(EXIT_FAILURE);
+	}
+	setNonBlocking(serverSocket);
+	return serverSocket;
+}
+
+// 读取cpu所在的NUMA节点，读不到时返回-1
+int cpuToNode(int cpu)
+{
+	std::string dir =
+		"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/";
+	for (int node = 0; node < MAX_NUMA_NODES; node++) {
+		std::string path = dir + "node" + std::to_string(node);
+		if (access(path.c_str(), F_OK) == 0) {
+			return node;
+		}
+	}
+	return -1;
+}
+
+// 把当前线程绑定到cpu上，并让之后的内存分配优先使用本地节点
+void placeWorker(int cpu, bool numa)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	if (err != 0) {
+		std::cerr << "Pinning worker to cpu " << cpu
+			  << " failed: " << strerror(err) << std::endl;
+	}
+
+	int node = numa ? cpuToNode(cpu) : -1;
+	if (node >= 0) {
+		unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+		mask[node / (8 * sizeof(unsigned long))] |=
+			1UL << (node % (8 * sizeof(unsigned long)));
+		if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask,
+			    MAX_NUMA_NODES + 1) == -1) {
+			perror("set_mempolicy failed");
+		}
+	}
+}
+
+struct WorkerConfig {
+	int port;
+	int cpu; // 绑定的核，-1表示不绑定
+	bool numa;
+	std::string rootDirectory;
+};
+
+// 每个worker拥有独立的监听套接字、epoll和时间轮，彼此之间不共享任何状态
+void runWorker(WorkerConfig config)
+{
+	if (config.cpu >= 0) {
+		placeWorker(config.cpu, config.numa);
+	}
+
+	// 绑定之后再分配，使连接表、时间轮等都落在本地节点上
+	EventLoop *loop = new EventLoop(nowTicks());
+	loop->serverSocket = createListener(config.port, config.cpu);
+	loop->rootDirectory = config.rootDirectory;
+	loop->epfd = epoll_create1(0);
+	if (loop->epfd == -1) {
+		perror("Epoll creation failed");
+		exit(EXIT_FAILURE);
+	}
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.ptr = nullptr; // 监听套接字
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->serverSocket, &ev) ==
+	    -1) {
+		perror("Epoll add failed");
+		exit(EXIT_FAILURE);
+	}
+
+	runEventLoop(*loop);
+
+	close(loop->epfd);
+	close(loop->serverSocket);
+	delete loop;
+}
+
+void usage(const char *prog)
+{
+	std::cerr << "Usage: " << prog
+		  << " <port> <root_directory> [-w workers] [-p] [-n]"
+		  << std::endl
+		  << "  -w  number of event-loop workers (default 1)"
+		  << std::endl
+		  << "  -p  pin each worker to its own core" << std::endl
+		  << "  -n  allocate worker memory from the local NUMA node (implies -p)"
+		  << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	int PORT = std::atoi(argv[1]);
+	std::string rootDirectory = argv[2];
+	int workers = 1;
+	bool pin = false;
+	bool numa = false;
+	for (int i = 3; i < argc; i++) {
+		std::string opt = argv[i];
+		if (opt == "-w" && i + 1 < argc) {
+			workers = std::atoi(argv[++i]);
+		} else if (opt == "-p") {
+			pin = true;
+		} else if (opt == "-n") {
+			pin = numa = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (workers < 1) {
+		workers = 1;
+	}
+
+	// 按进程允许使用的核依次分配给各个worker
+	std::vector<int> cpus;
+	cpu_set_t allowed;
+	if (pin && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &allowed)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+
+	std::cout << "Server is running on port " << PORT
+		  << " with root directory " << rootDirectory << std::endl;
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < workers; i++) {
+		WorkerConfig config;
+		config.port = PORT;
+		config.cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+		config.numa = numa;
+		config.rootDirectory = rootDirectory;
+		threads.push_back(std::thread(runWorker, config));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	return 0;
+}
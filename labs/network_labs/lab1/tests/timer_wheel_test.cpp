@@ -0,0 +1,70 @@
+// 时间轮的回归测试：g++ -std=c++11 -I.. timer_wheel_test.cpp -o timer_wheel_test && ./timer_wheel_test
+#include <cassert>
+#include <cstdio>
+
+#include "../timer_wheel.h"
+
+const uint64_t IDLE_TICKS = 150; // server.cpp中IDLE_TIMEOUT_MS对应的tick数
+
+static int fired;
+
+static void onExpire(TimerNode *)
+{
+	fired++;
+}
+
+// 轮空闲了比空闲超时更长的时间之后，新加的定时器不能在同一轮推进中到期
+static void testIdleGap()
+{
+	TimerWheel wheel(1000);
+	uint64_t now = 1000 + 10 * IDLE_TICKS; // epoll_wait(-1)期间过去的时间
+	wheel.sync(now);
+	assert(wheel.now() == now);
+
+	TimerNode node;
+	fired = 0;
+	wheel.add(&node, IDLE_TICKS);
+	wheel.advance(now, onExpire);
+	assert(fired == 0 && node.pending());
+	wheel.advance(now + IDLE_TICKS - 1, onExpire);
+	assert(fired == 0);
+	wheel.advance(now + IDLE_TICKS, onExpire);
+	assert(fired == 1 && !node.pending());
+}
+
+// 有定时器时sync不能跳过它们
+static void testSyncKeepsPending()
+{
+	TimerWheel wheel(0);
+	TimerNode node;
+	fired = 0;
+	wheel.add(&node, 5);
+	wheel.sync(100);
+	assert(wheel.now() == 0);
+	wheel.advance(100, onExpire);
+	assert(fired == 1);
+}
+
+// 空轮跳过多圈之后，跨越多层的定时器仍按时到期
+static void testCascadeAfterJump()
+{
+	TimerWheel wheel(0);
+	wheel.sync(TimerWheel::ROOT_SIZE * 3 + 17);
+	TimerNode node;
+	fired = 0;
+	uint64_t start = wheel.now();
+	wheel.add(&node, 5000);
+	wheel.advance(start + 4999, onExpire);
+	assert(fired == 0);
+	wheel.advance(start + 5000, onExpire);
+	assert(fired == 1);
+}
+
+int main()
+{
+	testIdleGap();
+	testSyncKeepsPending();
+	testCascadeAfterJump();
+	printf("timer_wheel_test: OK\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+
+// 时间轮上的定时器节点，嵌入到连接结构体中，插入/取消不需要分配内存
+struct TimerNode {
+	TimerNode *prev = nullptr;
+	TimerNode *next = nullptr;
+	uint64_t expire = 0; // 到期的tick
+	void *data = nullptr; // 到期时回调拿到的对象
+
+	bool pending() const
+	{
+		return prev != nullptr;
+	}
+};
+
+// 分层哈希时间轮：第0层256个槽，其余3层各64个槽，共覆盖2^26个tick
+// 插入和取消都是O(1)，高层的槽在低层转完一圈时才向下级联一次
+class TimerWheel {
+    public:
+	static const int ROOT_BITS = 8;
+	static const int LEVEL_BITS = 6;
+	static const int LEVELS = 4;
+	static const int ROOT_SIZE = 1 << ROOT_BITS;
+	static const int LEVEL_SIZE = 1 << LEVEL_BITS;
+	static const uint64_t MAX_TICKS =
+		(uint64_t)1 << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS);
+
+	explicit TimerWheel(uint64_t now = 0)
+		: current(now)
+		, count(0)
+	{
+		for (int i = 0; i < ROOT_SIZE; i++) {
+			initSlot(&root[i]);
+		}
+		for (int l = 0; l < LEVELS - 1; l++) {
+			for (int i = 0; i < LEVEL_SIZE; i++) {
+				initSlot(&levels[l][i]);
+			}
+		}
+	}
+
+	TimerWheel(const TimerWheel &) = delete;
+	TimerWheel &operator=(const TimerWheel &) = delete;
+
+	// 在ticks个tick之后触发，节点已在轮上时先取消
+	void add(TimerNode *node, uint64_t ticks)
+	{
+		if (node->pending()) {
+			cancel(node);
+		}
+		if (ticks == 0) {
+			ticks = 1;
+		}
+		if (ticks >= MAX_TICKS) {
+			ticks = MAX_TICKS - 1;
+		}
+		node->expire = current + ticks;
+		place(node);
+		count++;
+	}
+
+	void cancel(TimerNode *node)
+	{
+		if (!node->pending()) {
+			return;
+		}
+		node->prev->next = node->next;
+		node->next->prev = node->prev;
+		node->prev = node->next = nullptr;
+		count--;
+	}
+
+	// 推进到now，对每个到期的节点调用fn(node)；回调里可以重新add或cancel其他节点
+	template <typename F> void advance(uint64_t now, F fn)
+	{
+		sync(now);
+		while (current < now) {
+			current++;
+			int index = current & (ROOT_SIZE - 1);
+			if (index == 0) {
+				cascade(0);
+			}
+			TimerNode *slot = &root[index];
+			while (slot->next != slot) {
+				TimerNode *node = slot->next;
+				cancel(node);
+				fn(node);
+			}
+		}
+	}
+
+	// 轮上没有定时器时直接跳到now：长时间空闲后current不再落后，之后add的超时从真实时间算起
+	void sync(uint64_t now)
+	{
+		if (count == 0 && current < now) {
+			current = now;
+		}
+	}
+
+	uint64_t now() const
+	{
+		return current;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	int size() const
+	{
+		return count;
+	}
+
+    private:
+	TimerNode root[ROOT_SIZE];
+	TimerNode levels[LEVELS - 1][LEVEL_SIZE];
+	uint64_t current; // 已经处理到的tick
+	int count;
+
+	static void initSlot(TimerNode *slot)
+	{
+		slot->prev = slot->next = slot;
+	}
+
+	static void link(TimerNode *slot, TimerNode *node)
+	{
+		node->prev = slot->prev;
+		node->next = slot;
+		slot->prev->next = node;
+		slot->prev = node;
+	}
+
+	// 按剩余时间选择所在层，与Linux早期的定时器轮算法相同
+	void place(TimerNode *node)
+	{
+		if (node->expire <= current) {
+			// 级联时恰好到期，放到本tick即将处理的槽
+			link(&root[current & (ROOT_SIZE - 1)], node);
+			return;
+		}
+		uint64_t delta = node->expire - current;
+		if (delta < ROOT_SIZE) {
+			link(&root[node->expire & (ROOT_SIZE - 1)], node);
+		} else {
+			for (int l = 0; l < LEVELS - 1; l++) {
+				int shift = ROOT_BITS + (l + 1) * LEVEL_BITS;
+				if (l == LEVELS - 2 || delta < ((uint64_t)1 << shift)) {
+					int index = (node->expire >>
+						     (ROOT_BITS + l * LEVEL_BITS)) &
+						    (LEVEL_SIZE - 1);
+					link(&levels[l][index], node);
+					return;
+				}
+			}
+		}
+	}
+
+	// 把第l层当前槽的节点重新分配到更低的层
+	void cascade(int l)
+	{
+		int index = (current >> (ROOT_BITS + l * LEVEL_BITS)) &
+			    (LEVEL_SIZE - 1);
+		if (index == 0 && l + 1 < LEVELS - 1) {
+			cascade(l + 1);
+		}
+		TimerNode *slot = &levels[l][index];
+		TimerNode list;
+		if (slot->next == slot) {
+			return;
+		}
+		// 先整体摘下再逐个放回，避免节点被放回同一个槽时死循环
+		list.next = slot->next;
+		list.prev = slot->prev;
+		list.next->prev = &list;
+		list.prev->next = &list;
+		initSlot(slot);
+		while (list.next != &list) {
+			TimerNode *node = list.next;
+			list.next = node->next;
+			node->next->prev = &list;
+			place(node);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include "../include/NetworkSimulator.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// 各基准测试共用的消息源、校验接收端和参数解析
+
+// 应用层消息按序号生成，接收端按同样的规则校验；total小于0时源源不断，由运行时间决定何时结束
+struct SequenceSource : public MessageSource {
+    long total;
+    long submitted;
+
+    explicit SequenceSource(long messages) : total(messages), submitted(0) {}
+
+    static void fill(char *data, long index) {
+        memset(data, 0, Configuration::PAYLOAD_SIZE);
+        snprintf(data, Configuration::PAYLOAD_SIZE, "%020ld", index);
+    }
+
+    bool hasMore() { return total < 0 || submitted < total; }
+
+    void next(Message &msg) { fill(msg.data, submitted++); }
+};
+
+// 按SequenceSource的规则校验递交的消息，内容与序号对不上时计数
+struct CheckingSink : public MessageSink {
+    long delivered;
+    long misordered;
+
+    CheckingSink() : delivered(0), misordered(0) {}
+
+    void write(const Message &msg) {
+        char expect[Configuration::PAYLOAD_SIZE];
+        SequenceSource::fill(expect, delivered);
+        if (memcmp(expect, msg.data, sizeof(expect)) != 0) {
+            misordered++;
+        }
+        delivered++;
+    }
+};
+
+// 把逗号分隔的命令行参数拆开，忽略空项
+inline std::vector<std::string> splitList(const char *arg) {
+    std::vector<std::string> items;
+    std::string s(arg);
+    size_t begin = 0;
+    while (begin <= s.size()) {
+        size_t end = s.find(',', begin);
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+        if (end > begin) {
+            items.push_back(s.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+#endif
@@ -0,0 +1,121 @@
+// 校验和微基准：比较pUtils自带的校验和（源码实现的模拟网络环境或libnetsim）与Internet校验和、CRC32C各实现的单报文开销
+// 用法：checksum_bench [-n 报文总数]
+#include "../include/Global.h"
+#include "../include/Checksum.h"
+#include <chrono>
+#include <functional>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+const int BATCH = 4096; // 一批报文约200KB，放得进L2缓存
+
+static volatile int sink;
+
+static void measure(const char *name, long total,
+		    const std::function<void(int *)> &run)
+{
+	std::vector<int> out(BATCH);
+	long rounds = total / BATCH > 0 ? total / BATCH : 1;
+	run(out.data()); //预热
+	auto begin = std::chrono::steady_clock::now();
+	for (long r = 0; r < rounds; r++) {
+		run(out.data());
+		sink = out[r % BATCH];
+	}
+	double ns = std::chrono::duration<double, std::nano>(
+			    std::chrono::steady_clock::now() - begin)
+			    .count();
+	double perPacket = ns / (rounds * BATCH);
+	printf("%s,%.2f,%.1f\n", name, perPacket, 1e3 / perPacket);
+}
+
+int main(int argc, char *argv[])
+{
+	long total = 50000000;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			total = atol(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n packets]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (total <= 0 || optind < argc) {
+		fprintf(stderr, "usage: %s [-n packets]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<Packet> pkts(BATCH);
+	std::mt19937 rng(1);
+	for (Packet &p : pkts) {
+		p.seqnum = (int)rng();
+		p.acknum = (int)rng();
+		for (int i = 0; i < Configuration::PAYLOAD_SIZE; i++) {
+			p.payload[i] = (char)rng();
+		}
+	}
+	const Packet *data = pkts.data();
+
+	//批量实现必须和逐个计算的结果一致
+	std::vector<int> expect(BATCH), got(BATCH);
+	for (int i = 0; i < BATCH; i++) {
+		expect[i] = internetChecksum(pkts[i]);
+	}
+	internetChecksumBatch(data, BATCH, got.data());
+	if (expect != got) {
+		fprintf(stderr, "internet checksum batch mismatch\n");
+		return 1;
+	}
+	setChecksumSimd(false);
+	for (int i = 0; i < BATCH; i++) {
+		expect[i] = (int)crc32c(pkts[i]);
+	}
+	setChecksumSimd(true);
+	crc32cBatch(data, BATCH, got.data());
+	if (expect != got) {
+		fprintf(stderr, "crc32c batch mismatch\n");
+		return 1;
+	}
+
+	printf("# %ld packets, payload %d bytes, simd %s\n", total,
+	       Configuration::PAYLOAD_SIZE,
+	       checksumSimdAvailable() ? "avx2+sse4.2" : "unavailable");
+	printf("method,ns_per_packet,mpps\n");
+
+	measure("library", total, [&](int *out) {
+		for (int i = 0; i < BATCH; i++) {
+			out[i] = pUtils->calculateCheckSum(data[i]);
+		}
+	});
+
+	setChecksumSimd(false);
+	measure("internet_scalar", total, [&](int *out) {
+		for (int i = 0; i < BATCH; i++) {
+			out[i] = internetChecksum(data[i]);
+		}
+	});
+	measure("crc32c_table", total, [&](int *out) {
+		for (int i = 0; i < BATCH; i++) {
+			out[i] = (int)crc32c(data[i]);
+		}
+	});
+
+	setChecksumSimd(true);
+	measure("internet_batch_avx2", total, [&](int *out) {
+		internetChecksumBatch(data, BATCH, out);
+	});
+	measure("crc32c_sse42", total, [&](int *out) {
+		for (int i = 0; i < BATCH; i++) {
+			out[i] = (int)crc32c(data[i]);
+		}
+	});
+	measure("crc32c_batch_sse42", total, [&](int *out) {
+		crc32cBatch(data, BATCH, out);
+	});
+	return 0;
+}
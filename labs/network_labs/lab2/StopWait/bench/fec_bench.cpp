@@ -0,0 +1,176 @@
+// 前向纠错的代价和收益：在有丢包的链路上比较不同码率下的有效吞吐量和额外发送的校验报文
+// 用法：fec_bench [-p 协议,...] [-f 编码,...] [-l 丢包率,...] [-w 窗口] [-n 消息个数] [-B 平均突发长度] [-H 暂存时间] [-s 种子]
+// 编码为none、xor:k或rs:k:r；链路带宽有限，校验报文和重传一样占用发送时间，所以低码率在低丢包率下反而更慢
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/NetworkSimulator.h"
+#include "../include/SimTool.h"
+#include "../include/Fec.h"
+#include "BenchSupport.h"
+#include <chrono>
+#include <string>
+#include <strings.h>
+#include <unistd.h>
+#include <vector>
+
+NETSIM_GLOBAL Tool *pUtils;
+NETSIM_GLOBAL NetworkService *pns;
+
+const double PROPAGATION_DELAY = 5.0; // 单向传播时延
+const double TRANSMISSION_TIME = 0.01; // 每个报文的发送时间，即链路带宽为100报文/单位时间
+const int SEQ_NUM_BITS = 32;
+
+static double burst = 1;
+static int hold = FecConfig::DEFAULT_HOLD;
+static uint64_t seed = 1;
+
+// fec为nullptr时不加前向纠错
+static void runOnce(const char *protocol, const char *code, const FecConfig *fec,
+		    int window, double loss, long messages)
+{
+	SimTool tool;
+	tool.setSeed(seed);
+	NetworkSimulator *network = new NetworkSimulator();
+	SimConfig config;
+	ChannelConfig link;
+	link.setBurstLoss(loss, burst);
+	link.corruptRate = 0; //只比较丢包恢复
+	link.minDelay = PROPAGATION_DELAY;
+	link.jitter = 0;
+	link.transmissionTime = TRANSMISSION_TIME;
+	config.setChannels(link);
+	config.arrivalRate = 0;
+	network->setConfig(config);
+	network->setSeed(seed * 0x9e3779b97f4a7c15ULL + 1);
+	SequenceSource source(messages);
+	CheckingSink sink;
+	network->setMessageSource(&source);
+	network->setMessageSink(&sink);
+	FecNetwork *coded = fec ? new FecNetwork(network, *fec) : nullptr;
+	NetworkService *service = coded ? (NetworkService *)coded : network;
+	service->setRunMode(2);
+	pUtils = &tool;
+	pns = service;
+
+	RdtPair pair;
+	ProtocolRegistry::create(protocol, ProtocolOptions(window, SEQ_NUM_BITS),
+				 pair);
+	service->setRtdSender(pair.sender);
+	service->setRtdReceiver(pair.receiver);
+
+	auto begin = std::chrono::steady_clock::now();
+	service->start();
+	double wall = std::chrono::duration<double, std::milli>(
+			      std::chrono::steady_clock::now() - begin)
+			      .count();
+
+	const SimStats &stats = network->getStats();
+	FecStats fs = coded ? coded->getStats() : FecStats();
+	long dataPackets = coded ? fs.dataPackets : stats.dataPackets;
+	double d = sink.delivered > 0 ? (double)sink.delivered : 1;
+	double goodput = stats.lastDelivery > 0 ? sink.delivered / stats.lastDelivery : 0;
+	printf("%s,%.3f,%s,%d,%d,%.3f,%ld,%.2f,%.3f,%.3f,%.3f,%.3f,%ld,%ld,%.1f\n",
+	       protocol, loss, code, fec ? fec->k : 0, fec ? fec->r : 0,
+	       fec ? fec->rate() : 1.0, sink.delivered, goodput,
+	       goodput * TRANSMISSION_TIME, (dataPackets - sink.delivered) / d,
+	       fs.parityPackets / d, fs.recovered / d, stats.timeouts,
+	       sink.misordered, wall);
+	fflush(stdout);
+
+	delete pair.sender;
+	delete pair.receiver;
+	if (coded) {
+		delete coded; //同时delete network
+	} else {
+		delete network;
+	}
+	pns = nullptr;
+	pUtils = nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> protocols = { "GBN", "SR", "TCP" };
+	std::vector<std::string> codes = { "none", "xor:4", "xor:8", "xor:16", "rs:8:2", "rs:16:4", "rs:8:4" };
+	std::vector<double> losses = { 0.0, 0.01, 0.05, 0.1, 0.2 };
+	int window = 64;
+	long messages = 50000;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:f:l:w:n:B:H:s:")) != -1) {
+		switch (opt) {
+		case 'p':
+			protocols = splitList(optarg);
+			break;
+		case 'f':
+			codes = splitList(optarg);
+			break;
+		case 'l':
+			losses.clear();
+			for (const std::string &l : splitList(optarg)) {
+				losses.push_back(atof(l.c_str()));
+			}
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		case 'n':
+			messages = atol(optarg);
+			break;
+		case 'B':
+			burst = atof(optarg) > 1 ? atof(optarg) : 1;
+			break;
+		case 'H':
+			hold = atoi(optarg) > 0 ? atoi(optarg) : 0;
+			break;
+		case 's':
+			seed = strtoull(optarg, nullptr, 0);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-p protocols] [-f none,xor:k,rs:k:r,...] [-l losses] [-w window]\n"
+				"       [-n messages] [-B burst] [-H hold] [-s seed]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	for (const std::string &protocol : protocols) {
+		if (!ProtocolRegistry::has(protocol.c_str())) {
+			fprintf(stderr, "unknown protocol '%s', available:\n",
+				protocol.c_str());
+			ProtocolRegistry::list(stderr);
+			return 1;
+		}
+	}
+	std::vector<FecConfig> configs(codes.size());
+	for (size_t i = 0; i < codes.size(); i++) {
+		if (strcasecmp(codes[i].c_str(), "none") != 0 &&
+		    !parseFec(codes[i].c_str(), configs[i])) {
+			fprintf(stderr, "bad FEC '%s': use none, xor:k or rs:k:r with k <= %d, r <= %d\n",
+				codes[i].c_str(), FecConfig::MAX_K, FecConfig::MAX_R);
+			return 1;
+		}
+		configs[i].hold = hold;
+	}
+	if (window < 1 || window > Configuration::MAX_WINDOW_SIZE) {
+		fprintf(stderr, "window %d out of range [1, %d]\n", window,
+			Configuration::MAX_WINDOW_SIZE);
+		return 1;
+	}
+
+	printf("# link: %.0f packets per time unit, one-way delay %.1f, mean loss burst %.1f, window %d, %ld messages, FEC hold %d\n",
+	       1 / TRANSMISSION_TIME, PROPAGATION_DELAY, burst, window, messages,
+	       hold);
+	printf("protocol,loss,code,k,r,code_rate,delivered,goodput,utilization,retx_per_msg,parity_per_msg,recovered_per_msg,timeouts,misordered,wall_ms\n");
+	for (double loss : losses) {
+		for (const std::string &protocol : protocols) {
+			for (size_t i = 0; i < codes.size(); i++) {
+				bool none = strcasecmp(codes[i].c_str(), "none") == 0;
+				runOnce(protocol.c_str(), codes[i].c_str(),
+					none ? nullptr : &configs[i], window, loss,
+					messages);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,194 @@
+// 多个流共用一条瓶颈链路时的公平性和总吞吐量：每组流同时开始，比较不同协议之间、drop-tail与RED之间的带宽分配
+// 用法：flow_bench [-f 协议,...] [-q droptail,red] [-b 带宽] [-Q 队列容量] [-w 窗口] [-T 运行时间 | -n 每个流的消息个数] [-d 时延,...] [-s 种子]
+// 默认带宽10报文/时间单位，时延5时带宽时延积约100个报文，几个窗口64的流就会在瓶颈排队
+// -f中每一项是一个流，可以重复，例如TCP,GBN表示一个TCP流和一个GBN流竞争；-d按流依次给出单向时延，不足的沿用最后一个
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/MultiFlowSimulator.h"
+#include "../include/SimTool.h"
+#include "BenchSupport.h"
+#include <chrono>
+#include <string>
+#include <strings.h>
+#include <unistd.h>
+#include <vector>
+
+NETSIM_GLOBAL Tool *pUtils;
+NETSIM_GLOBAL NetworkService *pns;
+
+const int SEQ_NUM_BITS = 32;
+
+static double transmissionTime = 0.1; // 瓶颈链路每个报文的发送时间，即带宽的倒数
+static uint64_t seed = 1;
+
+static void runOnce(const std::vector<std::string> &protocols, QueuePolicy policy,
+		    int queueLimit, int window, double duration, long messages,
+		    const std::vector<double> &delays)
+{
+	SimTool tool;
+	tool.setSeed(seed);
+	pUtils = &tool;
+
+	MultiFlowSimulator sim;
+	BottleneckConfig bc;
+	bc.transmissionTime = transmissionTime;
+	bc.queueLimit = queueLimit;
+	bc.policy = policy;
+	sim.setBottleneck(bc);
+	sim.setSeed(seed * 0x9e3779b97f4a7c15ULL + 1);
+	sim.setRunMode(2);
+	sim.setDuration(duration);
+
+	size_t n = protocols.size();
+	std::vector<RdtPair> pairs(n);
+	std::vector<SequenceSource> sources(n, SequenceSource(duration > 0 ? -1 : messages));
+	std::vector<CheckingSink> sinks(n);
+	for (size_t i = 0; i < n; i++) {
+		FlowConfig fc;
+		fc.data.minDelay = fc.ack.minDelay = i < delays.size() ? delays[i] : delays.back();
+		ProtocolRegistry::create(protocols[i].c_str(),
+					 ProtocolOptions(window, SEQ_NUM_BITS), pairs[i]);
+		sim.addFlow(protocols[i].c_str(), pairs[i].sender, pairs[i].receiver,
+			    &sources[i], &sinks[i], fc);
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	sim.start();
+	double wall = std::chrono::duration<double, std::milli>(
+			      std::chrono::steady_clock::now() - begin)
+			      .count();
+
+	const char *queue = policy == QUEUE_RED ? "red" : "droptail";
+	double aggregate = sim.aggregateGoodput();
+	long drops = 0;
+	for (size_t i = 0; i < n; i++) {
+		const FlowStats &fs = sim.getFlowStats((int)i);
+		const StatsCollector &d = sim.getDetailedStats((int)i);
+		double g = sim.goodput((int)i);
+		printf("%s,%zu,%s,%.1f,%ld,%.2f,%.3f,%.3f,%ld,%ld,%.2f,%.2f,%ld\n",
+		       queue, i, protocols[i].c_str(),
+		       i < delays.size() ? delays[i] : delays.back(), fs.delivered,
+		       g, aggregate > 0 ? g / aggregate : 0,
+		       d.retransmissionRatio(), fs.timeouts, fs.queueDrops,
+		       d.getLatency().percentile(0.5), d.getLatency().percentile(0.99),
+		       sinks[i].misordered);
+		drops += fs.queueDrops;
+	}
+	const BottleneckQueue &q = sim.getBottleneck();
+	printf("# %s: aggregate %.2f, utilization %.3f, jain %.3f, queue drops %ld (early %ld), mean queue %.1f, mean queueing delay %.3f, wall %.1f ms\n",
+	       queue, aggregate, aggregate * transmissionTime, sim.jainIndex(),
+	       drops, q.getEarlyDrops(), q.meanLength(), q.meanDelay(), wall);
+	fflush(stdout);
+
+	for (RdtPair &pair : pairs) {
+		delete pair.sender;
+		delete pair.receiver;
+	}
+	pns = nullptr;
+	pUtils = nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> protocols = { "TCP", "GBN", "SR" };
+	std::vector<std::string> queues = { "droptail", "red" };
+	std::vector<double> delays = { 5.0 };
+	int queueLimit = 64;
+	int window = 64;
+	double duration = 2000;
+	long messages = 0;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "f:q:b:Q:w:T:n:d:s:")) != -1) {
+		switch (opt) {
+		case 'f':
+			protocols = splitList(optarg);
+			break;
+		case 'q':
+			queues = splitList(optarg);
+			break;
+		case 'b':
+			transmissionTime = atof(optarg) > 0 ? 1 / atof(optarg) : 0;
+			break;
+		case 'Q':
+			queueLimit = atoi(optarg);
+			break;
+		case 'w':
+			window = atoi(optarg);
+			break;
+		case 'T':
+			duration = atof(optarg);
+			break;
+		case 'n':
+			messages = atol(optarg);
+			duration = 0;
+			break;
+		case 'd':
+			delays.clear();
+			for (const std::string &d : splitList(optarg)) {
+				delays.push_back(atof(d.c_str()));
+			}
+			break;
+		case 's':
+			seed = strtoull(optarg, nullptr, 0);
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-f protocols] [-q droptail,red] [-b bandwidth] [-Q queue limit] [-w window]\n"
+				"       [-T duration | -n messages per flow] [-d delays] [-s seed]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (protocols.empty() || delays.empty()) {
+		fprintf(stderr, "need at least one flow and one delay\n");
+		return 1;
+	}
+	for (const std::string &protocol : protocols) {
+		if (!ProtocolRegistry::has(protocol.c_str())) {
+			fprintf(stderr, "unknown protocol '%s', available:\n",
+				protocol.c_str());
+			ProtocolRegistry::list(stderr);
+			return 1;
+		}
+	}
+	std::vector<QueuePolicy> policies;
+	for (const std::string &q : queues) {
+		if (strcasecmp(q.c_str(), "droptail") == 0) {
+			policies.push_back(QUEUE_DROP_TAIL);
+		} else if (strcasecmp(q.c_str(), "red") == 0) {
+			policies.push_back(QUEUE_RED);
+		} else {
+			fprintf(stderr, "unknown queue '%s': use droptail or red\n",
+				q.c_str());
+			return 1;
+		}
+	}
+	if (transmissionTime <= 0) {
+		fprintf(stderr, "bandwidth must be positive\n");
+		return 1;
+	}
+	if (window < 1 || window > Configuration::MAX_WINDOW_SIZE) {
+		fprintf(stderr, "window %d out of range [1, %d]\n", window,
+			Configuration::MAX_WINDOW_SIZE);
+		return 1;
+	}
+	if (duration <= 0 && messages <= 0) {
+		fprintf(stderr, "give a positive -T duration or -n messages\n");
+		return 1;
+	}
+
+	printf("# bottleneck: %.0f packets per time unit, queue limit %d, window %d, ",
+	       1 / transmissionTime, queueLimit, window);
+	if (duration > 0) {
+		printf("run for %.0f time units\n", duration);
+	} else {
+		printf("%ld messages per flow\n", messages);
+	}
+	printf("queue,flow,protocol,delay,delivered,goodput,share,retx_ratio,timeouts,queue_drops,latency_p50,latency_p99,misordered\n");
+	for (QueuePolicy policy : policies) {
+		runOnce(protocols, policy, queueLimit, window, duration, messages,
+			delays);
+	}
+	return 0;
+}
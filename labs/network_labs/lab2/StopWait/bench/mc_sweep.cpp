@@ -0,0 +1,436 @@
+// 蒙特卡洛参数扫描：对丢包率、损坏率、窗口大小、超时时间、延迟确认的每种组合，用不同的随机数种子各运行若干次仿真，
+// 多个线程并行，每次仿真有自己的模拟网络环境和随机数发生器，汇总后按组合输出CSV
+// 用法：mc_sweep [-p 协议,...] [-l 丢包率,...] [-c 损坏率,...] [-w 窗口,...] [-t 超时,...]
+//               [-k 延迟确认报文数,...] [-K 延迟确认时间]
+//               [-r 每组重复次数] [-n 消息个数] [-j 线程数] [-s 种子] [-R] [-o 输出文件] [信道参数]
+// -t为0表示使用默认的初始超时Configuration::TIME_OUT；大于0时作为初始RTO和RTO下限
+// -k为1表示每个报文都立即确认；大于1时接收方每k个按序报文确认一次，最多推迟-K个时间单位
+// -R输出每一次运行的结果而不是汇总；协议名见ProtocolRegistry
+// 信道参数对每个组合都相同：[-d 单向时延] [-J 抖动] [-B 平均突发长度] [-O 重排概率:额外延迟] [-D 复制概率]
+// [-a] 只在数据方向上丢包和损坏，确认方向无损
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/NetworkSimulator.h"
+#include "../include/SimTool.h"
+#include "../include/RttEstimator.h"
+#include "BenchSupport.h"
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <string>
+#include <strings.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+NETSIM_GLOBAL Tool *pUtils;
+NETSIM_GLOBAL NetworkService *pns;
+
+const double TRANSMISSION_TIME = 0.01; // 链路带宽100报文/单位时间，时延用SimConfig的默认值
+const int SEQ_NUM_BITS = 32;
+
+// 除丢包率和损坏率以外的信道参数，由命令行设置，所有组合共用
+static ChannelConfig baseLink;
+static double burst = 1;
+static bool cleanAcks = false;
+static int ackDelay = AckPolicy().delay;
+
+struct Params {
+	std::string protocol;
+	double loss;
+	double corrupt;
+	int window;
+	int timeout;
+	int ackEvery;
+};
+
+struct Result {
+	long delivered;
+	long misordered;
+	double simTime;
+	long dataPackets;
+	long ackPackets;
+	long timeouts;
+	long events;
+	double wallMs;
+};
+
+struct Job {
+	int combo; //参数组合的下标
+	int rep;
+	uint64_t seed;
+};
+
+// 在当前线程中完成一次仿真，pUtils和pns是线程局部的，只指向这次运行的实例
+static Result runOnce(const Params &p, uint64_t seed, long messages)
+{
+	SimTool tool;
+	tool.setSeed(seed);
+	NetworkSimulator network;
+	SimConfig config;
+	ChannelConfig link = baseLink;
+	link.setBurstLoss(p.loss, burst);
+	link.corruptRate = p.corrupt;
+	config.setChannels(link);
+	if (cleanAcks) {
+		config.channel[SENDER].setBurstLoss(0, 1);
+		config.channel[SENDER].corruptRate = 0;
+	}
+	config.arrivalRate = 0;
+	network.setConfig(config);
+	network.setSeed(seed * 0x9e3779b97f4a7c15ULL + 1);
+	network.setRunMode(2);
+	SequenceSource source(messages);
+	CheckingSink sink;
+	network.setMessageSource(&source);
+	network.setMessageSink(&sink);
+	pUtils = &tool;
+	pns = &network;
+	RttEstimator::setBaseTimeout(p.timeout);
+
+	ProtocolOptions options(p.window, SEQ_NUM_BITS);
+	options.ack = AckPolicy(p.ackEvery, ackDelay);
+	RdtPair pair;
+	ProtocolRegistry::create(p.protocol.c_str(),
+				 options, pair);
+	network.setRtdSender(pair.sender);
+	network.setRtdReceiver(pair.receiver);
+
+	auto begin = std::chrono::steady_clock::now();
+	network.start();
+	Result r;
+	r.wallMs = std::chrono::duration<double, std::milli>(
+			   std::chrono::steady_clock::now() - begin)
+			   .count();
+	const SimStats &stats = network.getStats();
+	r.delivered = sink.delivered;
+	r.misordered = sink.misordered;
+	r.simTime = stats.lastDelivery;
+	r.dataPackets = stats.dataPackets;
+	r.ackPackets = stats.ackPackets;
+	r.timeouts = stats.timeouts;
+	r.events = stats.events;
+
+	delete pair.sender;
+	delete pair.receiver;
+	pns = nullptr;
+	pUtils = nullptr;
+	return r;
+}
+
+static double goodput(const Result &r)
+{
+	return r.simTime > 0 ? r.delivered / r.simTime : 0;
+}
+
+// 重传率：每个消息额外发送的数据报文数
+static double retransmissions(const Result &r)
+{
+	return r.delivered > 0 ? (double)(r.dataPackets - r.delivered) / r.delivered : 0;
+}
+
+static double acksPerMessage(const Result &r)
+{
+	return r.delivered > 0 ? (double)r.ackPackets / r.delivered : 0;
+}
+
+struct Summary {
+	int n;
+	double sum;
+	double sumSq;
+
+	Summary()
+		: n(0)
+		, sum(0)
+		, sumSq(0)
+	{
+	}
+
+	void add(double x)
+	{
+		n++;
+		sum += x;
+		sumSq += x * x;
+	}
+
+	double mean() const
+	{
+		return n ? sum / n : 0;
+	}
+
+	// 均值的95%置信区间半宽，按正态近似
+	double ci95() const
+	{
+		if (n < 2) {
+			return 0;
+		}
+		double var = (sumSq - sum * sum / n) / (n - 1);
+		return 1.96 * sqrt(var > 0 ? var : 0) / sqrt((double)n);
+	}
+};
+
+template <typename T>
+static std::vector<T> parseList(const char *arg, T (*convert)(const char *))
+{
+	std::vector<T> values;
+	std::string s(arg);
+	size_t begin = 0;
+	while (begin <= s.size()) {
+		size_t end = s.find(',', begin);
+		if (end == std::string::npos) {
+			end = s.size();
+		}
+		if (end > begin) {
+			values.push_back(convert(s.substr(begin, end - begin).c_str()));
+		}
+		begin = end + 1;
+	}
+	return values;
+}
+
+static double toDouble(const char *s)
+{
+	return atof(s);
+}
+
+static int toInt(const char *s)
+{
+	return atoi(s);
+}
+
+static std::string toString(const char *s)
+{
+	return s;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> protocols = { "StopWait", "GBN", "SR", "TCP" };
+	std::vector<double> losses = { 0.0, 0.01, 0.05, 0.1 };
+	std::vector<double> corrupts = { 0.0, 0.01 };
+	std::vector<int> windows = { 1, 4, 16, 64, 256 };
+	std::vector<int> timeouts = { 0 };
+	std::vector<int> ackEvery = { 1 };
+	int reps = 8;
+	long messages = 20000;
+	int threads = (int)std::thread::hardware_concurrency();
+	uint64_t baseSeed = 1;
+	bool raw = false;
+	FILE *out = stdout;
+	baseLink.transmissionTime = TRANSMISSION_TIME;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:l:c:w:t:k:K:r:n:j:s:Ro:d:J:B:O:D:a")) != -1) {
+		switch (opt) {
+		case 'p':
+			protocols = parseList<std::string>(optarg, toString);
+			break;
+		case 'l':
+			losses = parseList<double>(optarg, toDouble);
+			break;
+		case 'c':
+			corrupts = parseList<double>(optarg, toDouble);
+			break;
+		case 'w':
+			windows = parseList<int>(optarg, toInt);
+			break;
+		case 't':
+			timeouts = parseList<int>(optarg, toInt);
+			break;
+		case 'k':
+			ackEvery = parseList<int>(optarg, toInt);
+			break;
+		case 'K':
+			ackDelay = atoi(optarg) > 0 ? atoi(optarg) : 1;
+			break;
+		case 'r':
+			reps = atoi(optarg);
+			break;
+		case 'n':
+			messages = atol(optarg);
+			break;
+		case 'j':
+			threads = atoi(optarg);
+			break;
+		case 's':
+			baseSeed = strtoull(optarg, nullptr, 0);
+			break;
+		case 'R':
+			raw = true;
+			break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if (!out) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'd':
+			baseLink.minDelay = atof(optarg);
+			break;
+		case 'J':
+			baseLink.jitter = atof(optarg);
+			break;
+		case 'B':
+			burst = atof(optarg);
+			break;
+		case 'O': {
+			const char *colon = strchr(optarg, ':');
+			baseLink.reorderRate = atof(optarg);
+			baseLink.reorderDelay = colon ? atof(colon + 1) : baseLink.jitter;
+			break;
+		}
+		case 'D':
+			baseLink.duplicateRate = atof(optarg);
+			break;
+		case 'a':
+			cleanAcks = true;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-p protocols] [-l losses] [-c corrupts] [-w windows] [-t timeouts]\n"
+				"       [-k ack_every] [-K ack_delay]\n"
+				"       [-r reps] [-n messages] [-j threads] [-s seed] [-R] [-o out.csv]\n"
+				"       [-d delay] [-J jitter] [-B burst] [-O rate[:delay]] [-D rate] [-a]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+	for (const std::string &protocol : protocols) {
+		if (!ProtocolRegistry::has(protocol.c_str())) {
+			fprintf(stderr, "unknown protocol '%s', available:\n",
+				protocol.c_str());
+			ProtocolRegistry::list(stderr);
+			return 1;
+		}
+	}
+	for (int w : windows) {
+		if (w < 1 || w > Configuration::MAX_WINDOW_SIZE) {
+			fprintf(stderr, "window %d out of range [1, %d]\n", w,
+				Configuration::MAX_WINDOW_SIZE);
+			return 1;
+		}
+	}
+
+	//停等协议没有窗口，只运行窗口为1的组合
+	std::vector<Params> combos;
+	for (const std::string &protocol : protocols) {
+		bool stopWait = strcasecmp(protocol.c_str(), "StopWait") == 0;
+		for (double loss : losses) {
+			for (double corrupt : corrupts) {
+				for (int window : windows) {
+					if (stopWait && window != windows.front()) {
+						continue;
+					}
+					for (int timeout : timeouts) {
+						for (int k : ackEvery) {
+							//停等协议不使用延迟确认，只运行一次
+							if (stopWait && k != ackEvery.front()) {
+								continue;
+							}
+							Params p;
+							p.protocol = protocol;
+							p.loss = loss;
+							p.corrupt = corrupt;
+							p.window = stopWait ? 1 : window;
+							p.timeout = timeout;
+							p.ackEvery = stopWait ? 1 : k;
+							combos.push_back(p);
+						}
+					}
+				}
+			}
+		}
+	}
+	std::vector<Job> jobs;
+	for (int c = 0; c < (int)combos.size(); c++) {
+		for (int rep = 0; rep < reps; rep++) {
+			Job job;
+			job.combo = c;
+			job.rep = rep;
+			job.seed = baseSeed + (uint64_t)c * 1000003 + rep;
+			jobs.push_back(job);
+		}
+	}
+
+	//工作线程每次领取下一个任务，运行时间差别很大的仿真也能均匀分摊到各个核上
+	std::vector<Result> results(jobs.size());
+	std::atomic<size_t> nextJob(0);
+	std::atomic<size_t> finished(0);
+	auto begin = std::chrono::steady_clock::now();
+	auto worker = [&]() {
+		for (;;) {
+			size_t i = nextJob++;
+			if (i >= jobs.size()) {
+				return;
+			}
+			results[i] = runOnce(combos[jobs[i].combo], jobs[i].seed,
+					     messages);
+			size_t done = ++finished;
+			if (done % 64 == 0 || done == jobs.size()) {
+				fprintf(stderr, "\r%zu/%zu runs", done, jobs.size());
+			}
+		}
+	};
+	std::vector<std::thread> pool;
+	for (int t = 0; t < threads; t++) {
+		pool.emplace_back(worker);
+	}
+	for (std::thread &t : pool) {
+		t.join();
+	}
+	double wall = std::chrono::duration<double>(
+			      std::chrono::steady_clock::now() - begin)
+			      .count();
+	fprintf(stderr, "\n%zu runs on %d threads in %.1f s\n", jobs.size(),
+		threads, wall);
+
+	fprintf(out, "# %ld messages per run, %d runs per combination, seed %llu\n",
+		messages, reps, (unsigned long long)baseSeed);
+	fprintf(out, "# delayed ACK timeout %d\n", ackDelay);
+	fprintf(out, "# link: delay %.2f + jitter %.2f, mean loss burst %.1f, reorder %.3f (+%.2f), duplicate %.3f%s\n",
+		baseLink.minDelay, baseLink.jitter, burst, baseLink.reorderRate,
+		baseLink.reorderDelay, baseLink.duplicateRate,
+		cleanAcks ? ", lossless ack path" : "");
+	if (raw) {
+		fprintf(out, "protocol,loss,corrupt,window,timeout,ack_every,seed,delivered,misordered,goodput,retx_per_msg,acks_per_msg,timeouts,events,wall_ms\n");
+		for (size_t i = 0; i < jobs.size(); i++) {
+			const Params &p = combos[jobs[i].combo];
+			const Result &r = results[i];
+			fprintf(out, "%s,%.3f,%.3f,%d,%d,%d,%llu,%ld,%ld,%.4f,%.4f,%.4f,%ld,%ld,%.1f\n",
+				p.protocol.c_str(), p.loss, p.corrupt, p.window,
+				p.timeout, p.ackEvery, (unsigned long long)jobs[i].seed,
+				r.delivered, r.misordered, goodput(r),
+				retransmissions(r), acksPerMessage(r),
+				r.timeouts, r.events, r.wallMs);
+		}
+	} else {
+		fprintf(out, "protocol,loss,corrupt,window,timeout,ack_every,runs,goodput,goodput_ci95,retx_per_msg,retx_ci95,acks_per_msg,timeouts,misordered,wall_ms\n");
+		for (int c = 0; c < (int)combos.size(); c++) {
+			Summary g, retx, acks, tmo, wallMs;
+			long misordered = 0;
+			for (int rep = 0; rep < reps; rep++) {
+				const Result &r = results[(size_t)c * reps + rep];
+				g.add(goodput(r));
+				retx.add(retransmissions(r));
+				acks.add(acksPerMessage(r));
+				tmo.add(r.timeouts);
+				wallMs.add(r.wallMs);
+				misordered += r.misordered;
+			}
+			const Params &p = combos[c];
+			fprintf(out, "%s,%.3f,%.3f,%d,%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%ld,%.1f\n",
+				p.protocol.c_str(), p.loss, p.corrupt, p.window,
+				p.timeout, p.ackEvery, reps, g.mean(), g.ci95(), retx.mean(),
+				retx.ci95(), acks.mean(), tmo.mean(), misordered,
+				wallMs.mean());
+		}
+	}
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,224 @@
+// 真实UDP传输的吞吐量和CPU开销：发送方和接收方在同一个进程里通过回环地址上的UDP套接字通信，
+// 协议实现与模拟网络环境中的完全相同，计时用挂钟时间，CPU时间包括系统调用
+// 用法：udp_bench [-p 协议,...] [-w 窗口,...] [-n 消息个数] [-u 时间单位微秒]
+//                 [-l 丢包率] [-c 损坏率] [-d 单向时延] [-J 抖动] [-B 平均突发长度] [-O 重排概率:额外延迟] [-D 复制概率]
+//                 [-k 延迟确认报文数[:延迟时间]] [-P [环形队列容量]] [-i 输入文件 -o 输出文件] [-v]
+// 给出-l/-c/-d/-J/-O/-D之一时报文先经过损伤层，时延以-u给出的时间单位计；两个方向使用相同的损伤参数
+// -k让接收方每k个按序报文确认一次，最多推迟若干个时间单位，比较确认报文数和发送方的CPU开销
+// -P把应用读写、协议处理、套接字收发分到三个线程，线程之间用SPSC环形队列连接
+// -i/-o时只用第一个协议和窗口传输文件，-v输出每个报文
+// payload大小在编译时决定（RDT_PAYLOAD_SIZE），udp_bench_512、udp_bench_1460、udp_bench_9000是不同大小的版本
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/UdpNetwork.h"
+#include "../include/SimTool.h"
+#include "BenchSupport.h"
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <vector>
+
+NETSIM_GLOBAL Tool *pUtils;
+NETSIM_GLOBAL NetworkService *pns;
+
+const int SEQ_NUM_BITS = 32;
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> protocols = { "StopWait", "GBN", "SR", "TCP" };
+	std::vector<int> windows = { 1, 16, 256 };
+	long messages = 200000;
+	UdpConfig config;
+	ChannelConfig link = config.channel[RECEIVER];
+	double loss = 0;
+	double burst = 1;
+	AckPolicy ack;
+	const char *input = nullptr;
+	const char *output = nullptr;
+	int runMode = 2;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:w:n:u:l:c:d:J:B:O:D:k:P::i:o:v")) != -1) {
+		switch (opt) {
+		case 'p':
+			protocols = splitList(optarg);
+			break;
+		case 'w':
+			windows.clear();
+			for (const std::string &w : splitList(optarg)) {
+				windows.push_back(atoi(w.c_str()));
+			}
+			break;
+		case 'n':
+			messages = atol(optarg);
+			break;
+		case 'u':
+			config.timeUnitUs = atoi(optarg) > 0 ? atoi(optarg) : 1;
+			break;
+		case 'l':
+			loss = atof(optarg);
+			config.impair = true;
+			break;
+		case 'c':
+			link.corruptRate = atof(optarg);
+			config.impair = true;
+			break;
+		case 'd':
+			link.minDelay = atof(optarg);
+			config.impair = true;
+			break;
+		case 'J':
+			link.jitter = atof(optarg);
+			config.impair = true;
+			break;
+		case 'B':
+			burst = atof(optarg);
+			break;
+		case 'O': {
+			const char *colon = strchr(optarg, ':');
+			link.reorderRate = atof(optarg);
+			link.reorderDelay = colon ? atof(colon + 1) : 1;
+			config.impair = true;
+			break;
+		}
+		case 'D':
+			link.duplicateRate = atof(optarg);
+			config.impair = true;
+			break;
+		case 'k': {
+			const char *colon = strchr(optarg, ':');
+			ack.every = atoi(optarg);
+			if (colon && atoi(colon + 1) > 0) {
+				ack.delay = atoi(colon + 1);
+			}
+			break;
+		}
+		case 'P':
+			config.pipeline = true;
+			if (optarg && atoi(optarg) > 0) {
+				config.ringSize = atoi(optarg);
+			}
+			break;
+		case 'i':
+			input = optarg;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'v':
+			runMode = 0;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-p protocols] [-w windows] [-n messages] [-u unit_us]\n"
+				"       [-l loss] [-c corrupt] [-d delay] [-J jitter] [-B burst] [-O rate[:delay]] [-D rate]\n"
+				"       [-k every[:delay]] [-P[ring]] [-i input -o output] [-v]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	link.setBurstLoss(loss, burst);
+	config.channel[SENDER] = config.channel[RECEIVER] = link;
+	if ((input == nullptr) != (output == nullptr)) {
+		fprintf(stderr, "-i and -o must be given together\n");
+		return 1;
+	}
+	for (const std::string &protocol : protocols) {
+		if (!ProtocolRegistry::has(protocol.c_str())) {
+			fprintf(stderr, "unknown protocol '%s', available:\n",
+				protocol.c_str());
+			ProtocolRegistry::list(stderr);
+			return 1;
+		}
+	}
+	for (int w : windows) {
+		if (w < 1 || w > Configuration::MAX_WINDOW_SIZE) {
+			fprintf(stderr, "window %d out of range [1, %d]\n", w,
+				Configuration::MAX_WINDOW_SIZE);
+			return 1;
+		}
+	}
+
+	SimTool tool;
+	pUtils = &tool;
+	if (input) {
+		UdpNetwork network;
+		network.setConfig(config);
+		network.setRunMode(runMode == 0 ? 0 : 1);
+		network.setInputFile(input);
+		network.setOutputFile(output);
+		pns = &network;
+		RdtPair pair;
+		ProtocolOptions options(windows.front(), SEQ_NUM_BITS);
+		options.ack = ack;
+		ProtocolRegistry::create(protocols.front().c_str(), options, pair);
+		network.setRtdSender(pair.sender);
+		network.setRtdReceiver(pair.receiver);
+		network.init();
+		network.start();
+		delete pair.sender;
+		delete pair.receiver;
+		pns = nullptr;
+		return 0;
+	}
+
+	printf("# loopback UDP, %ld messages of %d bytes, time unit %d us%s",
+	       messages, Configuration::PAYLOAD_SIZE, config.timeUnitUs,
+	       config.impair ? ", impairment shim on" : "");
+	if (config.pipeline) {
+		printf(", 3-thread pipeline with %d-slot rings", config.ringSize);
+	}
+	printf("\n");
+	if (ack.every > 1) {
+		printf("# delayed ACKs: every %d packets or %d time units\n",
+		       ack.every, ack.delay);
+	}
+	printf("protocol,window,delivered,wall_ms,msgs_per_s,payload_mbit_per_s,user_ms,sys_ms,cpu_us_per_msg,cpu_ns_per_byte,data_pkts_per_msg,ack_pkts_per_msg,timeouts,send_dropped,misordered\n");
+	for (const std::string &protocol : protocols) {
+		bool stopWait = strcasecmp(protocol.c_str(), "StopWait") == 0;
+		for (int window : windows) {
+			//停等协议没有窗口，只运行一次
+			if (stopWait && window != windows.front()) {
+				continue;
+			}
+			UdpNetwork network;
+			network.setConfig(config);
+			network.setRunMode(runMode);
+			SequenceSource source(messages);
+			CheckingSink sink;
+			network.setMessageSource(&source);
+			network.setMessageSink(&sink);
+			pns = &network;
+
+			ProtocolOptions options(stopWait ? 1 : window, SEQ_NUM_BITS);
+			options.ack = ack;
+			RdtPair pair;
+			ProtocolRegistry::create(protocol.c_str(), options, pair);
+			network.setRtdSender(pair.sender);
+			network.setRtdReceiver(pair.receiver);
+			network.start();
+
+			const UdpStats &s = network.getStats();
+			double cpu = s.userSeconds + s.systemSeconds;
+			double wall = s.wallSeconds > 0 ? s.wallSeconds : 1e-9;
+			double bytes = (double)sink.delivered * Configuration::PAYLOAD_SIZE;
+			printf("%s,%d,%ld,%.1f,%.0f,%.2f,%.1f,%.1f,%.2f,%.3f,%.3f,%.3f,%ld,%ld,%ld\n",
+			       protocol.c_str(), stopWait ? 1 : window, sink.delivered,
+			       wall * 1e3, sink.delivered / wall,
+			       bytes * 8 / wall / 1e6,
+			       s.userSeconds * 1e3, s.systemSeconds * 1e3,
+			       sink.delivered ? cpu * 1e6 / sink.delivered : 0,
+			       bytes > 0 ? cpu * 1e9 / bytes : 0,
+			       sink.delivered ? (double)s.dataPackets / sink.delivered : 0,
+			       sink.delivered ? (double)s.ackPackets / sink.delivered : 0,
+			       s.timeouts, s.sendDropped, sink.misordered);
+			fflush(stdout);
+
+			delete pair.sender;
+			delete pair.receiver;
+			pns = nullptr;
+		}
+	}
+	return 0;
+}
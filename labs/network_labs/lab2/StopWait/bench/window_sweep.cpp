@@ -0,0 +1,151 @@
+// 窗口大小扫描：在有丢包的链路上测量GBN/SR/TCP的吞吐量随窗口大小的变化
+// 用法：window_sweep [-p 协议,...] [-c cwnd.csv] [-b 突发长度] [消息个数] [丢包率...]
+// -c把TCP每次运行的拥塞窗口变化按仿真时间写入cwnd.csv
+// -b改用Gilbert-Elliott突发丢包，坏状态平均持续若干个报文，平均丢包率不变，用来比较TCP有无SACK时的重传量
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/TCPRdtSender.h"
+#include "../include/NetworkSimulator.h"
+#include "../include/SimTool.h"
+#include "BenchSupport.h"
+#include <chrono>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+NETSIM_GLOBAL Tool *pUtils;
+NETSIM_GLOBAL NetworkService *pns;
+
+const double PROPAGATION_DELAY = 5.0; // 单向传播时延
+const double TRANSMISSION_TIME = 0.002; // 每个报文的发送时间，即链路带宽为500报文/单位时间
+const int SEQ_NUM_BITS = 32;
+
+FILE *cwndLog = nullptr;
+double burst = 1;
+
+void runOnce(const char *protocol, int window, double loss, int messages)
+{
+	uint64_t seed = window * 7919 + (uint64_t)(loss * 1e6);
+	SimTool tool;
+	tool.setSeed(seed);
+	NetworkSimulator network;
+	SimConfig config;
+	ChannelConfig link;
+	link.setBurstLoss(loss, burst);
+	link.corruptRate = 0; //只比较丢包恢复，不产生比特错误
+	link.minDelay = PROPAGATION_DELAY;
+	link.jitter = 0;
+	link.transmissionTime = TRANSMISSION_TIME;
+	config.setChannels(link);
+	config.arrivalRate = 0;
+	network.setConfig(config);
+	network.setSeed(seed);
+	network.setRunMode(2);
+	SequenceSource source(messages);
+	CheckingSink sink;
+	network.setMessageSource(&source);
+	network.setMessageSink(&sink);
+	pUtils = &tool;
+	pns = &network;
+
+	RdtPair pair;
+	ProtocolRegistry::create(protocol, ProtocolOptions(window, SEQ_NUM_BITS),
+				 pair);
+	if (cwndLog) {
+		auto *tcp = dynamic_cast<TCPRdtSender *>(pair.sender);
+		if (tcp) {
+			tcp->setCwndObserver([&](double cwnd, int ssthresh) {
+				fprintf(cwndLog, "%.3f,%d,%.4f,%.3f,%d\n", loss,
+					window, network.now(), cwnd, ssthresh);
+			});
+		}
+	}
+	RdtSender *ps = pair.sender;
+	RdtReceiver *pr = pair.receiver;
+	network.setRtdSender(ps);
+	network.setRtdReceiver(pr);
+
+	auto begin = std::chrono::steady_clock::now();
+	network.start();
+	double wall = std::chrono::duration<double, std::milli>(
+			      std::chrono::steady_clock::now() - begin)
+			      .count();
+
+	const SimStats &stats = network.getStats();
+	double throughput =
+		stats.lastDelivery > 0 ? sink.delivered / stats.lastDelivery : 0;
+	printf("%s,%.3f,%d,%ld,%.2f,%.3f,%.3f,%ld,%ld,%.1f,%.2f\n", protocol,
+	       loss, window, sink.delivered, throughput,
+	       throughput * TRANSMISSION_TIME,
+	       (double)stats.dataPackets / messages, stats.timeouts,
+	       sink.misordered, wall, wall > 0 ? stats.events / wall / 1e3 : 0);
+	fflush(stdout);
+
+	delete ps;
+	delete pr;
+	pns = nullptr;
+	pUtils = nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> protocols = { "GBN", "SR", "TCP-NOSACK", "TCP" };
+	int opt;
+	while ((opt = getopt(argc, argv, "p:c:b:")) != -1) {
+		if (opt == 'p') {
+			protocols.clear();
+			char *save;
+			for (char *p = strtok_r(optarg, ",", &save); p;
+			     p = strtok_r(nullptr, ",", &save)) {
+				protocols.push_back(p);
+			}
+		} else if (opt == 'c') {
+			cwndLog = fopen(optarg, "w");
+			if (!cwndLog) {
+				perror(optarg);
+				return 1;
+			}
+			fprintf(cwndLog, "loss,window,time,cwnd,ssthresh\n");
+		} else if (opt == 'b') {
+			burst = atof(optarg) > 1 ? atof(optarg) : 1;
+		} else {
+			fprintf(stderr,
+				"usage: %s [-p protocols] [-c cwnd.csv] [-b burst] [messages] [loss...]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	int messages = argc > optind ? atoi(argv[optind]) : 100000;
+	std::vector<double> losses;
+	for (int i = optind + 1; i < argc; i++) {
+		losses.push_back(atof(argv[i]));
+	}
+	if (losses.empty()) {
+		losses = { 0.0, 0.01, 0.05 };
+	}
+
+	printf("# link: %.0f packets per time unit, one-way delay %.1f, initial timeout %d, mean loss burst %.1f\n",
+	       1 / TRANSMISSION_TIME, PROPAGATION_DELAY, Configuration::TIME_OUT,
+	       burst);
+	printf("protocol,loss,window,delivered,throughput,utilization,data_pkts_per_msg,timeouts,misordered,wall_ms,mevents_per_s\n");
+	for (const std::string &protocol : protocols) {
+		if (!ProtocolRegistry::has(protocol.c_str())) {
+			fprintf(stderr, "unknown protocol '%s', available:\n",
+				protocol.c_str());
+			ProtocolRegistry::list(stderr);
+			return 1;
+		}
+	}
+	for (double loss : losses) {
+		for (const std::string &protocol : protocols) {
+			for (int window = 1; window <= Configuration::MAX_WINDOW_SIZE;
+			     window *= 2) {
+				runOnce(protocol.c_str(), window, loss, messages);
+			}
+		}
+	}
+	if (cwndLog) {
+		fclose(cwndLog);
+	}
+	return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef BOTTLENECK_H
+#define BOTTLENECK_H
+
+#include "SimTool.h"
+#include <deque>
+
+// 瓶颈链路的队列管理
+enum QueuePolicy {
+    QUEUE_DROP_TAIL, // 队列满时丢弃新到的报文
+    QUEUE_RED // Random Early Detection（Floyd & Jacobson 1993）：按平均队列长度提前随机丢包，队列满时仍然丢弃
+};
+
+struct BottleneckConfig {
+    double transmissionTime; //每个报文占用链路的时间，即带宽的倒数
+    int queueLimit; //队列中（包括正在发送的）最多容纳的报文数
+    QueuePolicy policy;
+    double redMinTh; //平均队列长度低于它时不提前丢包；不大于0时取queueLimit/6
+    double redMaxTh; //平均队列长度达到它时全部丢弃；不大于0时取3 * redMinTh
+    double redMaxP; //平均队列长度接近redMaxTh时的丢包概率
+    double redWeight; //平均队列长度的EWMA权重
+
+    BottleneckConfig()
+        : transmissionTime(0.01)
+        , queueLimit(64)
+        , policy(QUEUE_DROP_TAIL)
+        , redMinTh(0)
+        , redMaxTh(0)
+        , redMaxP(0.1)
+        , redWeight(0.002)
+    {
+    }
+};
+
+// 所有流的数据报文共用的FIFO队列和链路：报文到达时决定丢弃或排队，返回它离开链路的时刻
+class BottleneckQueue {
+private:
+    BottleneckConfig config;
+    double minTh;
+    double maxTh;
+    std::deque<double> departures; //队列中报文离开链路的时刻
+    double linkFree;
+    double avg; //RED的平均队列长度
+    int count; //RED：上一次丢包以来进入[minTh, maxTh)之后到达的报文数，-1表示平均队列长度低于minTh
+
+    long arrivals;
+    long tailDrops;
+    long earlyDrops;
+    int maxLength;
+    double lengthSum; //每个到达的报文看到的队列长度之和
+    double delaySum; //被接受的报文的排队时延之和
+    bool dropEarly(int length, double now, SimRandom &rng);
+public:
+    BottleneckQueue() { configure(BottleneckConfig()); }
+    void configure(const BottleneckConfig &c); //同时清空队列和统计
+    const BottleneckConfig &getConfig() const { return config; }
+
+    double admit(double now, SimRandom &rng); //被丢弃时返回负数
+    int length(double now); //now时队列中的报文数
+
+    long getArrivals() const { return arrivals; }
+    long getTailDrops() const { return tailDrops; }
+    long getEarlyDrops() const { return earlyDrops; }
+    int getMaxLength() const { return maxLength; }
+    double meanLength() const { return arrivals ? lengthSum / arrivals : 0; } //到达的报文看到的平均队列长度
+    double meanDelay() const; //被接受的报文的平均排队时延，不含自己的发送时间
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "DataStructure.h"
+#include "SimTool.h"
+
+// 丢包模型
+enum LossModel {
+    LOSS_BERNOULLI, // 每个报文独立地以lossRate的概率丢失
+    LOSS_GILBERT_ELLIOTT // 两状态马尔可夫链：好状态丢包率lossGood，坏状态丢包率lossBad，产生突发丢包
+};
+
+// 一个方向上的链路参数，默认值与libnetsim.a相同
+struct ChannelConfig {
+    LossModel lossModel;
+    double lossRate; //LOSS_BERNOULLI的丢包率
+    double goodToBad; //LOSS_GILBERT_ELLIOTT：每个报文之后从好状态转入坏状态的概率
+    double badToGood; //每个报文之后从坏状态回到好状态的概率，坏状态平均持续1/badToGood个报文
+    double lossGood;
+    double lossBad;
+    double corruptRate; //报文损坏概率
+    double minDelay; //单向时延 = minDelay + jitter * [0,1)随机数
+    double jitter;
+    double transmissionTime; //每个报文占用链路的时间（带宽的倒数），为0时不限带宽
+    double reorderRate; //报文额外延迟reorderDelay的概率，被延迟的报文可能被后发的报文超过
+    double reorderDelay;
+    double duplicateRate; //报文被复制一份的概率，两份独立地经历时延
+
+    ChannelConfig()
+        : lossModel(LOSS_BERNOULLI)
+        , lossRate(0.1)
+        , goodToBad(0)
+        , badToGood(1)
+        , lossGood(0)
+        , lossBad(1)
+        , corruptRate(0.1)
+        , minDelay(1)
+        , jitter(10)
+        , transmissionTime(0)
+        , reorderRate(0)
+        , reorderDelay(0)
+        , duplicateRate(0)
+    {
+    }
+
+    // 设置为平均丢包率为loss、坏状态平均持续burst个报文、坏状态必丢的Gilbert-Elliott模型；burst不大于1时为Bernoulli模型
+    void setBurstLoss(double loss, double burst);
+    double averageLoss() const; //稳态下的平均丢包率
+};
+
+// 报文在信道中经历的结果
+struct Transmission {
+    bool lost;
+    bool corrupted;
+    bool reordered; //至少有一份被额外延迟，可能比后发的报文晚到
+    int copies; //到达对方的份数：0、1或2
+    double arrival[2];
+};
+
+// 一个方向上的信道：依次决定丢失、损坏、复制和每一份的到达时间
+// 不被重排的报文按发送顺序到达；丢失的报文同样占用链路
+class Channel {
+private:
+    ChannelConfig config;
+    bool bad; //Gilbert-Elliott当前是否处于坏状态
+    double linkFree; //链路空闲的时刻
+    double lastArrival; //按顺序到达的报文中最晚的到达时间
+    bool lose(SimRandom &rng);
+    void corrupt(Packet &pkt, SimRandom &rng);
+    double delay(double departure, SimRandom &rng, bool &reordered);
+public:
+    Channel();
+    void configure(const ChannelConfig &c); //同时复位信道状态
+    const ChannelConfig &getConfig() const { return config; }
+    Transmission transmit(double now, Packet &pkt, SimRandom &rng); //pkt可能被改动（损坏）
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include "Global.h"
+#include <stdint.h>
+
+// 校验和覆盖seqnum、acknum和payload，不包括checksum字段本身
+enum ChecksumKind {
+    CHECKSUM_LIBRARY, // pUtils自带的calculateCheckSum
+    CHECKSUM_INTERNET, // RFC 1071的16位反码和
+    CHECKSUM_CRC32C // Castagnoli CRC，SSE4.2有专门的crc32指令
+};
+
+// 单个报文的校验和；CPU支持时CRC32C使用SSE4.2指令
+uint16_t internetChecksum(const Packet &pkt);
+uint32_t crc32c(const Packet &pkt);
+
+// 一次计算一批报文的校验和，结果写入out[0..n)
+// Internet校验和在支持AVX2时每8个报文一组，用gather把同一位置的字并行累加
+void internetChecksumBatch(const Packet *pkts, int n, int *out);
+void crc32cBatch(const Packet *pkts, int n, int *out);
+
+// 按pUtils当前的算法计算一批报文的校验和：pUtils是ChecksumTool时用上面的批量实现，否则逐个调用calculateCheckSum
+// 发送方的receiveBatch用它校验整批确认包
+void checksumBatch(const Packet *pkts, int n, int *out);
+
+bool checksumSimdAvailable();
+void setChecksumSimd(bool enable); // 关闭后强制使用标量实现，便于对比
+
+// 替换pUtils的校验和算法，打印和随机数仍交给原来的Tool
+class ChecksumTool : public Tool {
+private:
+    Tool *inner;
+    const ChecksumKind kind;
+public:
+    ChecksumTool(Tool *tool, ChecksumKind k);
+    virtual ~ChecksumTool();
+    void printPacket(const char *description, const Packet &packet);
+    int calculateCheckSum(const Packet &packet);
+    void calculateCheckSumBatch(const Packet *pkts, int n, int *out);
+    double random();
+};
+
+#endif
@@ -1,20 +1,39 @@
 #ifndef DATA_STRUCTURE_H
 #define DATA_STRUCTURE_H
 
+//默认21字节，与预编译的libnetsim.a一致；使用源码实现的模拟网络环境时可以在编译时用RDT_PAYLOAD_SIZE改变
+#ifndef RDT_PAYLOAD_SIZE
+#define RDT_PAYLOAD_SIZE 21
+#endif
+
 struct  Configuration{
 
 	/**
 	定义各层协议Payload数据的大小（字节为单位）
+	最大65000字节：加上报文头后仍能放进一个UDP数据报
 	*/
-	static const int PAYLOAD_SIZE = 21;
+	static const int PAYLOAD_SIZE = RDT_PAYLOAD_SIZE;
 
 	/**
 	定时器时间
 	*/
 	static const int TIME_OUT =20;
 
+	/**
+	发送/接收窗口的最大长度，窗口缓冲区按此长度静态分配，必须是2的幂
+	payload较大时相应减小，使每个窗口缓冲区不超过16MiB左右
+	*/
+	static const int MAX_WINDOW_SIZE = PAYLOAD_SIZE <= 2048 ? 8192 :
+					   PAYLOAD_SIZE <= 4096 ? 4096 :
+					   PAYLOAD_SIZE <= 8192 ? 2048 :
+					   PAYLOAD_SIZE <= 16384 ? 1024 :
+					   PAYLOAD_SIZE <= 32768 ? 512 : 256;
+
 };
 
+static_assert(Configuration::PAYLOAD_SIZE >= 21 && Configuration::PAYLOAD_SIZE <= 65000,
+	      "RDT_PAYLOAD_SIZE must be between 21 and 65000");
+
 
 
 /**
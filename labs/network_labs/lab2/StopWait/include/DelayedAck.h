@@ -0,0 +1,67 @@
+#ifndef DELAYED_ACK_H
+#define DELAYED_ACK_H
+
+#include "Global.h"
+
+// 延迟确认的参数：按序到达的报文每攒够every个才确认一次，不够时最多推迟delay个时间单位
+// every <= 1表示不延迟，每个报文都立即确认
+struct AckPolicy {
+    int every;
+    int delay;
+
+    AckPolicy(int k = 1, int d = 2) : every(k), delay(d) {}
+};
+
+// 接收方的延迟确认（RFC 1122、RFC 5681）：只推迟按序到达的报文的确认，乱序、重复的报文和补上缺口的报文仍然立即确认
+// 推迟的确认由接收方定时器(RECEIVER, TIMER_ID)到时后发出，需要模拟网络环境把接收方定时器交给RdtReceiver::timeoutHandler，
+// 预编译的libnetsim.a不支持
+class DelayedAck {
+private:
+    AckPolicy policy;
+    int pending; //已经推迟确认的报文个数
+    bool timerRunning;
+public:
+    static const int TIMER_ID = 0;
+
+    explicit DelayedAck(const AckPolicy &p = AckPolicy())
+        : policy(p), pending(0), timerRunning(false) {}
+
+    bool enabled() const { return policy.every > 1; }
+
+    // 收到一个按序报文，返回true表示现在就要发送确认
+    bool onInOrder() {
+        if (!enabled()) {
+            return true;
+        }
+        if (++pending >= policy.every) {
+            sent();
+            return true;
+        }
+        if (!timerRunning) {
+            pns->startTimer(RECEIVER, policy.delay, TIMER_ID);
+            timerRunning = true;
+        }
+        return false;
+    }
+
+    // 发送了一个确认，之前推迟的确认都包含在里面
+    void sent() {
+        pending = 0;
+        if (timerRunning) {
+            pns->stopTimer(RECEIVER, TIMER_ID);
+            timerRunning = false;
+        }
+    }
+
+    // 定时器到时，返回true表示有推迟的确认需要发送
+    bool onTimeout() {
+        timerRunning = false;
+        if (pending == 0) {
+            return false;
+        }
+        pending = 0;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <stdint.h>
+#include <vector>
+
+// 离散事件调度器使用的二叉最小堆，按(time, order)排序：同一时刻的事件按加入的先后处理
+// T必须有double time和uint64_t order两个成员，order由队列在push时填写
+// 出堆时采用"空穴下沉"：先把空穴沉到底再把末尾元素上浮，比逐层交换少一半比较和拷贝
+template <typename T>
+class EventQueue {
+private:
+    std::vector<T> heap;
+    uint64_t nextOrder;
+
+    static bool before(const T &a, const T &b) {
+        return a.time != b.time ? a.time < b.time : a.order < b.order;
+    }
+public:
+    EventQueue() : nextOrder(0) {}
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    const T &top() const { return heap.front(); }
+    void reserve(size_t n) { heap.reserve(n); }
+    void clear() { heap.clear(); }
+
+    // 返回分配给该事件的order，调用方可以用它作为取消事件的凭据
+    uint64_t push(T e) {
+        e.order = nextOrder++;
+        size_t i = heap.size();
+        heap.push_back(e);
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(e, heap[parent]))
+                break;
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = e;
+        return e.order;
+    }
+
+    T pop() {
+        T result = heap.front();
+        T last = heap.back();
+        heap.pop_back();
+        size_t n = heap.size();
+        if (n == 0)
+            return result;
+        size_t i = 0;
+        for (;;) {
+            size_t child = 2 * i + 1;
+            if (child >= n)
+                break;
+            if (child + 1 < n && before(heap[child + 1], heap[child]))
+                child++;
+            heap[i] = heap[child];
+            i = child;
+        }
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!before(last, heap[parent]))
+                break;
+            heap[i] = heap[parent];
+            i = parent;
+        }
+        heap[i] = last;
+        return result;
+    }
+};
+
+#endif
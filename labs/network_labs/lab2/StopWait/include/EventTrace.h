@@ -0,0 +1,99 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include "RandomEventEnum.h"
+#include "WirePacket.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// 二进制事件跟踪：模拟网络环境把每个事件写成一条定长记录，先放在预先分配的缓冲区里，满了才整块写入文件。
+// 记录一个事件只是填一个结构体，不做格式化输出，大规模仿真时也可以一直打开。
+// 用tools/trace2pcap转换成pcap文件后，可以配合tools/rdt_trace.lua在Wireshark中查看
+enum TraceEvent {
+    TRACE_SEND = 1, //报文交给网络层，target为接收报文的一方：RECEIVER是数据报文，SENDER是确认报文
+    TRACE_ARRIVE = 2, //报文到达target（可能已经损坏）
+    TRACE_TIMEOUT = 3, //target的定时器到时，timer为定时器编号
+    TRACE_DELIVER = 4 //接收方向应用层递交消息，payload为消息内容
+};
+
+// TRACE_SEND的结果
+enum TraceFlag {
+    TRACE_LOST = 1,
+    TRACE_CORRUPTED = 2,
+    TRACE_DUPLICATED = 4, //信道复制了报文，随后有多个TRACE_ARRIVE
+    TRACE_REORDERED = 8 //有一份副本被额外延迟
+};
+
+struct TraceRecord {
+    double time; //仿真时间
+    uint8_t kind; //TraceEvent
+    uint8_t target; //RandomEventTarget
+    uint8_t flags; //TraceFlag的组合
+    uint8_t reserved;
+    int32_t timer; //TRACE_TIMEOUT的定时器编号，其他事件为0
+    WirePacket packet; //TRACE_TIMEOUT时全为0
+};
+
+static_assert(std::is_trivially_copyable<TraceRecord>::value, "TraceRecord must be trivially copyable");
+
+// 文件格式：TraceFileHeader后面紧跟若干条TraceRecord，均为本机字节序（报文内容是WirePacket的大端格式）
+struct TraceFileHeader {
+    char magic[8]; //"RDTTRACE"
+    uint32_t version;
+    uint32_t recordSize; //sizeof(TraceRecord)，读取时据此判断是否兼容
+    uint32_t payloadSize; //Configuration::PAYLOAD_SIZE
+    uint32_t reserved;
+};
+
+class TraceWriter {
+private:
+    FILE *file;
+    std::vector<TraceRecord> buffer;
+    size_t used;
+    long records; //已经记录的事件数，包括还在缓冲区里的
+    void flush();
+    TraceRecord &append(double time, TraceEvent kind, RandomEventTarget target) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        TraceRecord &r = buffer[used++];
+        r.time = time;
+        r.kind = (uint8_t)kind;
+        r.target = (uint8_t)target;
+        r.flags = 0;
+        r.reserved = 0;
+        r.timer = 0;
+        records++;
+        return r;
+    }
+public:
+    static const uint32_t VERSION = 1;
+    static const size_t DEFAULT_CAPACITY = 1 << 16; //记录条数
+
+    explicit TraceWriter(size_t capacity = DEFAULT_CAPACITY);
+    ~TraceWriter(); //写出缓冲区中剩下的记录并关闭文件
+    bool open(const char *path); //创建文件并写入文件头，失败时返回false
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    long size() const { return records; }
+
+    // 返回的记录在下一次记录事件前有效，可以补填flags
+    TraceRecord &packet(double time, TraceEvent kind, RandomEventTarget target, const Packet &pkt) {
+        TraceRecord &r = append(time, kind, target);
+        r.packet.encode(pkt);
+        return r;
+    }
+    void timeout(double time, RandomEventTarget target, int timer) {
+        TraceRecord &r = append(time, TRACE_TIMEOUT, target);
+        r.timer = timer;
+        memset(&r.packet, 0, sizeof(r.packet));
+    }
+    void deliver(double time, const Message &msg) {
+        TraceRecord &r = append(time, TRACE_DELIVER, RECEIVER);
+        memset(&r.packet.header, 0, sizeof(r.packet.header));
+        memcpy(r.packet.payload, msg.data, sizeof(r.packet.payload));
+    }
+};
+
+#endif
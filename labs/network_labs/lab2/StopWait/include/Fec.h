@@ -0,0 +1,122 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include "Global.h"
+#include "RttEstimator.h"
+#include <stdint.h>
+#include <vector>
+
+// 前向纠错：发送方每发出k个数据报文就追加r个校验报文，接收方在一个块中收到任意k个报文时就能恢复丢失或损坏的数据报文，不需要重传
+enum FecCode {
+    FEC_XOR, // 一个校验报文，是k个数据报文的异或，能恢复一个丢失
+    FEC_RS // GF(2^8)上的Cauchy Reed-Solomon码，r个校验报文能恢复任意r个丢失
+};
+
+struct FecConfig {
+    FecCode code;
+    int k; //每块的数据报文数
+    int r; //每块的校验报文数
+    int hold; //块中有缺口时，后面的数据报文最多暂存这么多个时间单位等待恢复，按序交给接收方；0表示不暂存
+
+    static const int MAX_K = 64;
+    static const int MAX_R = 16;
+    static const int DEFAULT_HOLD = 5;
+
+    FecConfig(FecCode c = FEC_XOR, int n = 8, int m = 1, int h = DEFAULT_HOLD)
+        : code(c), k(n), r(m), hold(h) {}
+    bool valid() const;
+    double rate() const { return (double)k / (k + r); } //码率
+};
+
+// 解析"xor:k"或"rs:k:r"，格式错误或参数超出范围时返回false
+bool parseFec(const char *spec, FecConfig &config);
+
+struct FecStats {
+    long dataPackets; //编码过的数据报文
+    long parityPackets;
+    long recovered; //由校验报文恢复出来并交给接收方的数据报文
+    long failed; //恢复出来但校验和不对，多半是校验报文在信道中被损坏了
+    long suppressed; //已经恢复过、后来才到达的原报文，不再交给接收方
+
+    FecStats() : dataPackets(0), parityPackets(0), recovered(0), failed(0), suppressed(0) {}
+};
+
+class FecNetwork;
+
+// 接收方一侧的解码器，由FecNetwork交给内层网络环境，代替真正的接收方收报文
+// GBN接收方丢弃乱序报文，缺口后面的报文先交上去就白收了，所以hold大于0时块内按位置顺序递交：
+// 缺口由校验报文补上、后一个块的报文开始到达或者暂存定时器到时，才把暂存的报文交给接收方。
+// 暂存定时器是接收方定时器，预编译的libnetsim.a不支持，这时hold必须为0
+class FecDecoder : public RdtReceiver {
+private:
+    struct Block {
+        uint32_t id;
+        bool used;
+        bool done; //已经尝试过恢复，或者数据报文已经收齐
+        uint64_t dataMask; //收到或恢复了哪些校验和正确的数据报文
+        uint64_t deliveredMask; //其中已经交给接收方的
+        uint32_t parityMask;
+        std::vector<uint8_t> data; //k个符号
+        std::vector<uint8_t> parity; //r个符号
+    };
+    static const int BLOCK_SLOTS = 32; //同时保留的块数，更早的块中迟到的报文直接交给接收方
+    static const int HOLD_TIMER = -1; //暂存定时器的编号，与DelayedAck::TIMER_ID不同
+
+    FecNetwork &owner;
+    RdtReceiver *upper;
+    std::vector<Block> blocks;
+    bool holdTimer;
+    Block *blockFor(uint32_t id);
+    void tryDecode(Block &b);
+    void deliver(Block &b, bool release); //按位置顺序递交，release为true时跳过缺口
+    void releaseBefore(uint32_t id); //递交比id早的块中暂存的报文
+    void armHold(const Block &b);
+public:
+    explicit FecDecoder(FecNetwork &network);
+    virtual ~FecDecoder();
+    void setReceiver(RdtReceiver *pr) { upper = pr; }
+    void receive(const Packet &packet);
+    void timeoutHandler(int seqNum); //接收方自己的定时器（延迟确认）原样转交
+};
+
+// 在RdtSender/RdtReceiver和网络环境之间加一层前向纠错，与ChecksumTool包装pUtils一样包装pns：
+//   pns = new FecNetwork(pns, config);
+// 发往接收方的数据报文在acknum字段（数据报文中不使用，总是-1）中带上块号和块内位置，交给接收方前恢复为-1，
+// 所以协议实现和校验和都不需要改动。校验报文按符号（seqnum、checksum和payload）编码，放在同样的三个字段中，
+// acknum标记为校验报文。不足k个的块不发校验报文，由协议原来的重传恢复。确认报文和定时器原样转交，时钟转发底层的
+class FecNetwork : public NetworkService, public SimClock {
+private:
+    NetworkService *inner;
+    const FecConfig config;
+    FecDecoder decoder;
+    uint32_t blockId; //正在编码的块
+    int filled; //当前块中已发出的数据报文数
+    std::vector<uint8_t> parity; //当前块的r个校验符号，随数据报文增量累加
+    FecStats stats;
+    int runMode;
+    friend class FecDecoder;
+public:
+    FecNetwork(NetworkService *network, const FecConfig &c); //取得network的所有权
+    virtual ~FecNetwork();
+
+    void startTimer(RandomEventTarget target, int timeOut, int seqNum);
+    void stopTimer(RandomEventTarget target, int seqNum);
+    void sendToNetworkLayer(RandomEventTarget target, Packet pkt);
+    void delivertoAppLayer(RandomEventTarget target, Message msg);
+
+    void init();
+    void start();
+    void setRtdSender(RdtSender *ps);
+    void setRtdReceiver(RdtReceiver *pr);
+    void setInputFile(const char *ifile);
+    void setOutputFile(const char *ofile);
+    void setRunMode(int mode = 0);
+
+    double now() const;
+    bool hasClock() const { return SimClock::of(inner) != nullptr; }
+
+    const FecConfig &getConfig() const { return config; }
+    const FecStats &getStats() const { return stats; }
+};
+
+#endif
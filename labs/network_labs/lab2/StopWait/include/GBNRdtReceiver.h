@@ -1,17 +1,21 @@
 #ifndef GBN_RDT_RECEIVER_H
 #define GBN_RDT_RECEIVER_H
 #include "RdtReceiver.h"
+#include "DelayedAck.h"
+#include "SeqNum.h"
 
 class GBNRdtReceiver : public RdtReceiver {
 private:
-    const unsigned int MAX_SEQ;
+    const SeqSpace seqSpace; //序号空间
     int expectedSeqNum; //期待收到的下一个报文序号
     Packet lastAckPkt; //上次发送的确认报文缓冲区
+    DelayedAck delayedAck;
 public:
-    GBNRdtReceiver(int seqNumBits = 16);
+    GBNRdtReceiver(int seqNumBits = 16, const AckPolicy &ack = AckPolicy());
     virtual ~GBNRdtReceiver();
 public:
     void receive(const Packet &packet); //接收报文，将被NetworkService调用
+    void timeoutHandler(int seqNum); //延迟确认定时器到时，发出推迟的确认
 };
 
 #endif
\ No newline at end of file
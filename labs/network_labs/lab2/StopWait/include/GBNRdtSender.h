@@ -1,20 +1,29 @@
 #ifndef GBN_RDT_SENDER_H
 #define GBN_RDT_SENDER_H
 #include "RdtSender.h"
-#include <unordered_map>
+#include "RingBuffer.h"
+#include "RttEstimator.h"
+#include "SeqNum.h"
+#include <vector>
 
 class GBNRdtSender : public RdtSender {
 private:
-    const unsigned int MAX_SEQ; //最大序列号+1
+    const SeqSpace seqSpace; //序号空间
     const int N; //窗口大小
     int base;
     int nextSeqNum;
-    std::unordered_map<int, Packet> pkts; // 已发送并等待Ack的数据包
+    RingBuffer<Packet, Configuration::MAX_WINDOW_SIZE> pkts; // 已发送并等待Ack的数据包
+    RttEstimator rtt;
+    std::vector<int> ackSums; //receiveBatch中整批确认包的校验和
+    void restartTimer(); //窗口前移后为剩下的未确认报文重新计时
 public:
     bool send(const Message &message); // 发送应用层下来的Message，由NetworkServiceSimulator调用,如果发送方成功地将Message发送到网络层，返回true;如果因为发送方处于等待正确确认状态而拒绝发送Message，则返回false
     void receive(const Packet &ackPkt); // 接受确认Ack，将被NetworkServiceSimulator调用
     void timeoutHandler(int seqNum); // Timeout handler，将被NetworkServiceSimulator调用
     bool getWaitingState();
+    int sendBatch(Span<const Message> messages); //一次填满窗口，只在窗口原来为空时启动一次定时器
+    void receiveBatch(Span<const Packet> ackPkts); //累计确认只需处理其中确认得最远的一个
+    int outstanding() { return (int)seqSpace.distance(base, nextSeqNum); }
 public:
     GBNRdtSender(int n = 4, int seqNumBits = 16);
     virtual ~GBNRdtSender();
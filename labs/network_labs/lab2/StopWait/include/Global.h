@@ -9,7 +9,14 @@
 #include <string.h>
 using namespace std;
 
-extern  Tool *pUtils;						//指向唯一的工具类实例，只在main函数结束前delete
-extern  NetworkService *pns;				//指向唯一的模拟网络环境类实例，只在main函数结束前delete
+//源码实现的模拟网络环境中两个指针是线程局部的，每个线程可以运行自己的仿真；预编译的libnetsim.a中是普通全局变量
+#ifdef NETSIM_PREBUILT
+#define NETSIM_GLOBAL
+#else
+#define NETSIM_GLOBAL thread_local
+#endif
+
+extern NETSIM_GLOBAL Tool *pUtils;						//指向唯一的工具类实例，只在main函数结束前delete
+extern NETSIM_GLOBAL NetworkService *pns;				//指向唯一的模拟网络环境类实例，只在main函数结束前delete
 
 #endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+#ifndef MULTI_FLOW_SIMULATOR_H
+#define MULTI_FLOW_SIMULATOR_H
+
+#include "Global.h"
+#include "Bottleneck.h"
+#include "Channel.h"
+#include "EventQueue.h"
+#include "NetworkSimulator.h"
+#include "RttEstimator.h"
+#include "StatsCollector.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 一个流在瓶颈之外的路径：数据报文离开瓶颈链路后经过data到达接收方，确认报文经过ack直接回到发送方（反向不拥塞）
+// 默认两个方向都无损、无抖动、单向时延5；不同流设置不同的时延就有不同的RTT
+struct FlowConfig {
+    ChannelConfig data;
+    ChannelConfig ack;
+    double startTime; //流开始发送的时刻
+
+    FlowConfig()
+        : startTime(0)
+    {
+        data.lossRate = ack.lossRate = 0;
+        data.corruptRate = ack.corruptRate = 0;
+        data.minDelay = ack.minDelay = 5;
+        data.jitter = ack.jitter = 0;
+    }
+};
+
+struct FlowStats {
+    long messages; //发送方接受的消息数
+    long delivered;
+    long dataPackets; //包括重传
+    long ackPackets;
+    long queueDrops; //在瓶颈队列被丢弃的数据报文
+    long pathLost; //在data、ack信道中丢失的报文
+    long timeouts;
+    double lastDelivery;
+
+    FlowStats() : messages(0), delivered(0), dataPackets(0), ackPackets(0), queueDrops(0),
+                  pathLost(0), timeouts(0), lastDelivery(0) {}
+};
+
+// 多个流共用一条瓶颈链路的模拟网络环境，每个流有自己的RdtSender/RdtReceiver，协议可以不同。
+// 协议通过全局的pns调用网络环境，所以每个流有一个代表自己的NetworkService（FlowPort），
+// 调用某个流的发送方或接收方之前把pns换成它的FlowPort，返回后再换回来；协议实现不需要任何改动。
+// 应用层总有数据可发；消息个数由各流的MessageSource决定，也可以用setDuration只运行一段时间。
+// 只能在源码实现的模拟网络环境上使用
+class MultiFlowSimulator {
+private:
+    class FlowPort : public NetworkService, public SimClock {
+    private:
+        MultiFlowSimulator &sim;
+        const int flow;
+    public:
+        FlowPort(MultiFlowSimulator &s, int f) : sim(s), flow(f) {}
+        void startTimer(RandomEventTarget target, int timeOut, int seqNum);
+        void stopTimer(RandomEventTarget target, int seqNum);
+        void sendToNetworkLayer(RandomEventTarget target, Packet pkt);
+        void delivertoAppLayer(RandomEventTarget target, Message msg);
+        // 以下由MultiFlowSimulator统一管理，协议不会调用
+        void init() {}
+        void start() {}
+        void setRtdSender(RdtSender *) {}
+        void setRtdReceiver(RdtReceiver *) {}
+        void setInputFile(const char *) {}
+        void setOutputFile(const char *) {}
+        void setRunMode(int) {}
+        double now() const { return sim.currentTime; }
+    };
+
+    struct Flow {
+        std::string name;
+        RdtSender *sender;
+        RdtReceiver *receiver;
+        MessageSource *source;
+        MessageSink *sink;
+        FlowConfig config;
+        FlowPort *port;
+        Channel data;
+        Channel ack;
+        MessageFeeder feeder;
+        bool started;
+        FlowStats stats;
+        StatsCollector detail;
+    };
+
+    enum EventKind { FLOW_START, PACKET_ARRIVAL, TIMEOUT };
+    struct Event {
+        double time;
+        uint64_t order;
+        int kind;
+        int flow;
+        RandomEventTarget target;
+        int seqNum;
+        int slot;
+    };
+
+    int runMode; //0或1：结束时打印统计，2：不输出任何信息
+    double duration; //大于0时只运行到这个时刻
+    SimRandom rng;
+    BottleneckQueue bottleneck;
+    std::vector<Flow *> flows;
+    EventQueue<Event> events;
+    std::vector<Packet> packets; //在途报文池
+    std::vector<int> freeSlots;
+    std::unordered_map<uint64_t, uint64_t> timers; //(flow, target, seqNum) -> 超时事件的order
+    double currentTime;
+
+    static uint64_t timerKey(int flow, RandomEventTarget target, int seqNum) {
+        return ((uint64_t)flow << 33) | ((uint64_t)target << 32) | (uint32_t)seqNum;
+    }
+    void startTimer(int flow, RandomEventTarget target, int timeOut, int seqNum);
+    void stopTimer(int flow, RandomEventTarget target, int seqNum);
+    void send(int flow, RandomEventTarget target, Packet &pkt);
+    void deliver(int flow, const Message &msg);
+    void schedulePacket(int flow, RandomEventTarget target, const Packet &pkt, double arrival);
+    void feed(Flow &f);
+    bool cancelled(const Event &e) const; //与NetworkSimulator相同，取消的定时器出堆时丢弃，不推进时钟
+    void dispatch(const Event &e);
+public:
+    MultiFlowSimulator();
+    ~MultiFlowSimulator();
+
+    void setBottleneck(const BottleneckConfig &c) { bottleneck.configure(c); }
+    void setSeed(uint64_t seed) { rng.setSeed(seed); }
+    void setRunMode(int mode) { runMode = mode; }
+    void setDuration(double t) { duration = t; }
+
+    // 加入一个流，返回流的编号；不转移sender、receiver、source、sink的所有权
+    int addFlow(const char *name, RdtSender *sender, RdtReceiver *receiver,
+                MessageSource *source, MessageSink *sink, const FlowConfig &config = FlowConfig());
+    void start(); //运行到所有流的消息都发完并且没有待处理的事件，或者到达duration
+
+    double now() const { return currentTime; }
+    int flowCount() const { return (int)flows.size(); }
+    const char *flowName(int i) const { return flows[i]->name.c_str(); }
+    const FlowStats &getFlowStats(int i) const { return flows[i]->stats; }
+    const StatsCollector &getDetailedStats(int i) const { return flows[i]->detail; }
+    const BottleneckQueue &getBottleneck() const { return bottleneck; }
+
+    double goodput(int i) const; //流i从开始到结束（或最后一次递交）平均每个时间单位递交的消息数
+    double aggregateGoodput() const;
+    double jainIndex() const; //各流goodput的Jain公平性指数，1表示完全公平，1/n表示一个流独占
+    void printStats() const;
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef NETWORK_SIMULATOR_H
+#define NETWORK_SIMULATOR_H
+
+#include "Global.h"
+#include "Channel.h"
+#include "EventQueue.h"
+#include "EventTrace.h"
+#include "RttEstimator.h"
+#include "SimTool.h"
+#include "StatsCollector.h"
+#include <unordered_map>
+#include <vector>
+
+// 模拟网络环境的参数，默认值与libnetsim.a相同
+struct SimConfig {
+    ChannelConfig channel[2]; //两个方向上的信道，下标为接收报文的一方：channel[RECEIVER]传数据，channel[SENDER]传确认
+    double arrivalRate; //应用层消息的到达率；不大于0时应用层总有数据可发，发送方一空闲就交给它
+
+    SimConfig()
+        : arrivalRate(0.5)
+    {
+    }
+
+    void setChannels(const ChannelConfig &c) { channel[SENDER] = channel[RECEIVER] = c; }
+};
+
+// 一次仿真的统计，前7项就是结束时打印的内容
+struct SimStats {
+    long messages; //已发送应用层Message个数
+    long dataPackets;
+    long dataLost;
+    long dataCorrupted;
+    long ackPackets;
+    long ackLost;
+    long ackCorrupted;
+    long duplicated; //信道复制出的报文数，两个方向合计
+    long reordered; //被额外延迟、可能乱序到达的报文数
+    long delivered; //向上递交给应用层的Message个数
+    long timeouts;
+    long events; //处理过的事件数，不含被取消的定时器
+    double lastDelivery; //最后一次向上递交的仿真时间
+
+    SimStats() { clear(); }
+    void clear() {
+        messages = dataPackets = dataLost = dataCorrupted = 0;
+        ackPackets = ackLost = ackCorrupted = 0;
+        duplicated = reordered = 0;
+        delivered = timeouts = events = 0;
+        lastDelivery = 0;
+    }
+};
+
+// 应用层消息的来源和去向。默认从输入文件按PAYLOAD_SIZE字节一块读取、写到输出文件，
+// 也可以换成内存中生成和校验的实现，比如基准测试
+struct MessageSource {
+    virtual bool hasMore() = 0;
+    virtual void next(Message &msg) = 0;
+    virtual ~MessageSource() {}
+};
+
+struct MessageSink {
+    virtual void write(const Message &msg) = 0;
+    virtual ~MessageSink() {}
+};
+
+// 从MessageSource预取一批消息交给RdtSender::sendBatch，发送方没有接受的留到下一次
+class MessageFeeder {
+private:
+    static const int BATCH = 64;
+    MessageSource *source;
+    std::vector<Message> buffer; //payload可能很大，不放在对象里，仿真器常常是栈上的局部变量
+    int head;
+    int tail;
+public:
+    MessageFeeder() : source(nullptr), buffer(BATCH), head(0), tail(0) {}
+    void reset(MessageSource *s) { source = s; head = tail = 0; }
+    bool hasMore() const { return head < tail || source->hasMore(); }
+
+    // 一直交给发送方直到它不再接受或消息取完，返回被接受的消息个数
+    long feed(RdtSender *sender) {
+        long accepted = 0;
+        for (;;) {
+            if (head == tail) {
+                head = tail = 0;
+                while (tail < BATCH && source->hasMore()) {
+                    source->next(buffer[tail++]);
+                }
+                if (tail == 0) {
+                    break;
+                }
+            }
+            int n = sender->sendBatch(Span<const Message>(&buffer[head], tail - head));
+            head += n;
+            accepted += n;
+            if (head < tail) {
+                break;
+            }
+        }
+        return accepted;
+    }
+};
+
+// 读写文件的默认实现，与libnetsim相同：最后不足一块的部分补0，写出时跳过0字节。打开失败返回nullptr
+MessageSource *openFileSource(const char *path);
+MessageSink *openFileSink(const char *path);
+
+// 模拟网络环境的源码实现，可以替换libnetsim.a中的NetworkServiceSimulator
+// 事件保存在二叉堆里，每个事件只有32字节，在途报文的内容放在对象池中按下标引用；
+// stopTimer不在堆里查找，只从定时器表中删掉，过期的超时事件出堆时再丢弃，不推进时钟
+class NetworkSimulator : public NetworkService, public SimClock {
+private:
+    enum EventKind { APP_ARRIVAL, PACKET_ARRIVAL, TIMEOUT };
+    struct Event {
+        double time;
+        uint64_t order;
+        int kind;
+        RandomEventTarget target;
+        int seqNum;
+        int slot; //PACKET_ARRIVAL：报文在packets中的下标
+    };
+
+    SimConfig config;
+    SimRandom rng;
+    int runMode; //0：VERBOSE模式，1：安静模式，只输出启动信息和统计，2：不输出任何信息
+    RdtSender *sender;
+    RdtReceiver *receiver;
+    const char *inputFile;
+    const char *outputFile;
+    MessageSource *source;
+    MessageSink *sink;
+    MessageFeeder feeder;
+    TraceWriter *trace;
+    StatsCollector detail;
+    bool collectRequested;
+    bool collecting; //本次运行是否收集detail
+
+    EventQueue<Event> events;
+    std::vector<Packet> packets; //在途报文池
+    std::vector<int> freeSlots;
+    std::vector<Packet> ackBatch; //同一时刻到达发送方的确认包，一起交给receiveBatch
+    std::unordered_map<uint64_t, uint64_t> timers; //(target, seqNum) -> 超时事件的order
+    double currentTime;
+    Channel channels[2]; //下标为接收报文的一方
+    SimStats stats;
+
+    static uint64_t timerKey(RandomEventTarget target, int seqNum) {
+        return ((uint64_t)target << 32) | (uint32_t)seqNum;
+    }
+    bool verbose() const { return runMode == 0; }
+    void scheduleAppArrival();
+    void feed();
+    void schedulePacket(RandomEventTarget target, Packet &pkt, double arrival);
+    void deliverAcks(const Event &first);
+    bool cancelled(const Event &e) const; //已被stopTimer取消，或同一序号又启动了新的定时器
+    void dispatch(const Event &e);
+    void run();
+    void printStats();
+public:
+    NetworkSimulator();
+    virtual ~NetworkSimulator();
+
+    void startTimer(RandomEventTarget target, int timeOut, int seqNum);
+    void stopTimer(RandomEventTarget target, int seqNum);
+    void sendToNetworkLayer(RandomEventTarget target, Packet pkt);
+    void delivertoAppLayer(RandomEventTarget target, Message msg);
+
+    void init();
+    void start();
+    void setRtdSender(RdtSender *ps);
+    void setRtdReceiver(RdtReceiver *pr);
+    void setInputFile(const char *ifile);
+    void setOutputFile(const char *ofile);
+    void setRunMode(int mode = 0);
+
+    double now() const { return currentTime; }
+
+    // 以下接口libnetsim没有，需要时通过dynamic_cast<NetworkSimulator *>(pns)使用
+    void setConfig(const SimConfig &c); //同时复位两个方向的信道状态
+    const SimConfig &getConfig() const { return config; }
+    void setSeed(uint64_t seed) { rng.setSeed(seed); }
+    void setMessageSource(MessageSource *s) { source = s; } //不转移所有权
+    void setMessageSink(MessageSink *s) { sink = s; }
+    void setTrace(TraceWriter *t) { trace = t; } //记录二进制事件跟踪，不转移所有权；nullptr表示不记录
+    const SimStats &getStats() const { return stats; }
+    // 吞吐量、时延直方图、窗口占用等详细统计。runMode不为2时总是收集并在结束时打印，为2时（基准测试）需要用这个接口打开
+    void setCollectStats(bool on) { collectRequested = on; }
+    const StatsCollector &getDetailedStats() const { return detail; }
+};
+
+#endif
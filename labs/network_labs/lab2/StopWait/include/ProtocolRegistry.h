@@ -0,0 +1,60 @@
+#ifndef PROTOCOL_REGISTRY_H
+#define PROTOCOL_REGISTRY_H
+
+#include "RdtSender.h"
+#include "RdtReceiver.h"
+#include "DelayedAck.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// 创建协议实体时的参数，各协议只使用自己需要的部分
+struct ProtocolOptions {
+    int window; //发送窗口（SR、TCP的接收窗口也取这个值）
+    int seqNumBits; //序号位数
+    AckPolicy ack; //GBN、SR、TCP接收方的延迟确认，默认不延迟
+
+    ProtocolOptions(int n = 4, int bits = 3) : window(n), seqNumBits(bits) {}
+};
+
+// 一对相互配合的发送方和接收方，由调用者delete
+struct RdtPair {
+    RdtSender *sender;
+    RdtReceiver *receiver;
+};
+
+typedef RdtPair (*ProtocolFactory)(const ProtocolOptions &options);
+
+// 协议的窗口受序号位数限制的方式，与SeqSpace::window一致
+enum WindowLimit {
+    WINDOW_ANY, //不使用窗口，或者协议自己检查
+    WINDOW_CUMULATIVE, //接收方只收按序的报文：窗口最多2^bits - 1
+    WINDOW_SELECTIVE //接收方缓存乱序报文：窗口最多2^(bits-1)
+};
+
+// 按名字创建协议实体，取代main.cpp中按编译选项选择协议的#ifdef
+// 内置StopWait、GBN、SR、TCP和TCP-NOSACK，新的协议可以在运行时用add注册
+class ProtocolRegistry {
+private:
+    struct Entry {
+        std::string name;
+        std::string description;
+        ProtocolFactory factory;
+        WindowLimit limit;
+    };
+    static std::vector<Entry> &entries();
+    static Entry *find(const char *name);
+public:
+    static void add(const char *name, const char *description, ProtocolFactory factory,
+                    WindowLimit limit = WINDOW_ANY);
+    // 名字不区分大小写。接收方构造时要计算校验和，create前pUtils必须已经设置好
+    static bool has(const char *name);
+    static bool create(const char *name, const ProtocolOptions &options, RdtPair &pair);
+    // 协议在seqNumBits位序号下允许的最大窗口，没有限制或不认识的协议返回0。
+    // 协议实体会把过大的窗口压到这个值，create前应当先检查，免得实际运行的窗口与要求的不同
+    static int maxWindow(const char *name, int seqNumBits);
+    static std::vector<std::string> names();
+    static void list(FILE *out); //每行一个协议：名字和说明
+};
+
+#endif
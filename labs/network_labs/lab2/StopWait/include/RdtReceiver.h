@@ -10,6 +10,13 @@ struct  RdtReceiver
 {
 	virtual void receive(const Packet &packet) = 0;		//接收报文，将被NetworkService调用	
 	virtual ~RdtReceiver() = 0;
+
+	//libnetsim.a不会调用，放在析构函数之后，不改变receive在虚表中的位置
+	virtual void timeoutHandler(int seqNum);		//接收方定时器（如延迟确认）到时，将被NetworkService调用；默认不使用定时器
 };
 
+inline void RdtReceiver::timeoutHandler(int)
+{
+}
+
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define RDT_SENDER_H
 
 #include "DataStructure.h"
+#include "Span.h"
 //定义RdtSender抽象类，规定了必须实现的三个接口方法
 //具体的子类比如StopWaitRdtSender、GBNRdtSender必须给出这三个方法的具体实现
 //只考虑单向传输，即发送方只发送数据和接受确认
@@ -12,6 +13,35 @@ struct  RdtSender
 	virtual void timeoutHandler(int seqNum) = 0;					//Timeout handler，将被NetworkService调用
 	virtual bool getWaitingState() = 0;								//返回RdtSender是否处于等待状态，如果发送方正等待确认或者发送窗口已满，返回true
 	virtual ~RdtSender() = 0;
+
+	//以下两个批量接口libnetsim.a不会调用，放在析构函数之后，不改变原有虚函数在虚表中的位置
+	virtual int sendBatch(Span<const Message> messages);			//按顺序发送messages中的前若干个Message，返回被接受的个数；默认逐个调用send，直到发送方进入等待状态
+	virtual void receiveBatch(Span<const Packet> ackPkts);			//处理同时到达的一批Ack；默认逐个调用receive。窗口协议可以只移动一次窗口、只重启一次定时器
+	virtual int outstanding();										//已发送但还没有被确认的报文数，用于统计窗口占用；默认返回-1表示不知道
 };
 
+inline int RdtSender::sendBatch(Span<const Message> messages)
+{
+	int accepted = 0;
+	for (const Message &message : messages) {
+		if (getWaitingState() || !send(message)) {
+			break;
+		}
+		accepted++;
+	}
+	return accepted;
+}
+
+inline void RdtSender::receiveBatch(Span<const Packet> ackPkts)
+{
+	for (const Packet &ackPkt : ackPkts) {
+		receive(ackPkt);
+	}
+}
+
+inline int RdtSender::outstanding()
+{
+	return -1;
+}
+
 #endif
@@ -0,0 +1,25 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+// 以序号为下标的定长环形缓冲区，slot = seq % CAPACITY
+// 元素连续存放在对象内部，发送/确认路径上不做任何哈希和内存分配
+// CAPACITY必须是2的幂：只要窗口不超过CAPACITY，序号回绕后窗口内的序号仍各自占用不同的槽
+template <typename T, int CAPACITY>
+class RingBuffer {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "RingBuffer capacity must be a power of two");
+private:
+    T slots[CAPACITY];
+public:
+    static const int SIZE = CAPACITY;
+
+    T &operator[](int seq) {
+        return slots[(unsigned int)seq & (CAPACITY - 1)];
+    }
+
+    const T &operator[](int seq) const {
+        return slots[(unsigned int)seq & (CAPACITY - 1)];
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+struct NetworkService;
+
+// 能提供仿真时间的网络环境额外实现这个接口，发送方据此给报文计时。
+// NetworkService的虚函数表要与预编译的libnetsim.a保持一致，不能往里加接口，所以单独定义，运行时用dynamic_cast查找
+// 包装别的网络环境的一层（如FecNetwork）也实现这个接口并转发now，底层没有时钟时hasClock返回false
+struct SimClock {
+    virtual double now() const = 0;
+    virtual bool hasClock() const { return true; }
+    virtual ~SimClock() {}
+
+    // ns提供的时钟，没有时返回nullptr
+    static const SimClock *of(const NetworkService *ns);
+};
+
+// 按RFC 6298（Jacobson/Karels）估计RTT并计算重传超时时间RTO
+// 同一时刻只给一个报文计时；被重传过的报文不取样（Karn算法）。超时后RTO指数退避，
+// 有新数据被确认时撤销退避：丢包率高时GBN这样的发送方可能长时间取不到有效样本，退避不能一直保持下去。
+// 但有时钟时在取到第一个样本之前保持退避，否则RTT大于初始RTO时每个被计时的报文都会超时重传，永远取不到样本。
+// 网络环境不提供时钟时不取样，RTO保持Configuration::TIME_OUT，但退避照常进行
+class RttEstimator {
+private:
+    static const int MAX_BACKOFF = 64;
+    static thread_local int baseTimeout;
+    const SimClock *clock;
+    bool clockResolved;
+    const int minRto;
+    double srtt;
+    double rttvar;
+    double rto;
+    bool hasSample;
+    int backoff; //退避倍数
+    bool timing; //是否有报文正在计时
+    int timedSeq;
+    double timedAt;
+    const SimClock *getClock();
+public:
+    RttEstimator();
+    void onSend(int seq); //新报文第一次发送，当前没有在计时的报文时开始给它计时
+    bool isTiming() const { return timing; }
+    int getTimedSeq() const { return timedSeq; }
+    void onAck(); //正在计时的报文被确认，取一个RTT样本
+    void onNewAck(); //有新数据被确认，撤销退避
+    void cancel(); //正在计时的报文（可能）被重传，放弃这次计时
+    void onTimeout(); //超时重传：RTO加倍，并放弃计时
+    int timeout() const; //当前应该设置的定时器时长
+    double getSrtt() const { return srtt; }
+    double getRttvar() const { return rttvar; }
+    // 之后在本线程中构造的估计器以t作为初始RTO，并且RTO不会低于t；默认为Configuration::TIME_OUT，不设下限
+    static void setBaseTimeout(int t) { baseTimeout = t; }
+};
+
+#endif
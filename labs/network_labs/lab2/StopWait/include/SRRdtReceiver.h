@@ -1,21 +1,29 @@
 #ifndef SR_RDT_RECEIVER_H
 #define SR_RDT_RECEIVER_H
 #include "RdtReceiver.h"
-#include <unordered_map>
+#include "DelayedAck.h"
+#include "RingBuffer.h"
+#include "SeqBitmap.h"
+#include "SeqNum.h"
 
 class SRRdtReceiver : public RdtReceiver {
 private:
-    const unsigned int MAX_SEQ;
+    const SeqSpace seqSpace; //序号空间
     const int N;
     int base;
-    std::unordered_map<int, Packet> cache;
+    RingBuffer<Packet, Configuration::MAX_WINDOW_SIZE> cache; // 按received.slot(seq)存放的乱序报文
+    SeqBitmap<Configuration::MAX_WINDOW_SIZE> received; // cache中哪些槽已经收到了报文
+    DelayedAck delayedAck;
+    int ackFrom; // [ackFrom, base)是已经按序递交、还没有单独确认的报文
     inline bool inWindow(int seqNum);
     inline bool inPrevWindow(int seqNum);
+    void sendAck(int seqNum);
 public:
-    SRRdtReceiver(int n=4, int seqNumBits = 16);
+    SRRdtReceiver(int n=4, int seqNumBits = 16, const AckPolicy &ack = AckPolicy());
     virtual ~SRRdtReceiver();
 public:
     void receive(const Packet &packet); //接收报文，将被NetworkService调用
+    void timeoutHandler(int seqNum); //延迟确认定时器到时，发出推迟的确认
 };
 
 #endif
\ No newline at end of file
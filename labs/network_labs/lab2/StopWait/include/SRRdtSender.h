@@ -1,22 +1,38 @@
 #ifndef SR_RDT_SENDER_H
 #define SR_RDT_SENDER_H
 #include "RdtSender.h"
-#include <unordered_map>
+#include "RingBuffer.h"
+#include "RttEstimator.h"
+#include "SeqNum.h"
+#include "TimerWheel.h"
+#include <utility>
+#include <vector>
 
 class SRRdtSender : public RdtSender {
 private:
-    const unsigned int MAX_SEQ; //最大序列号+1
+    const SeqSpace seqSpace; //序号空间
     const int N; //窗口大小
     int base;
     int nextSeqNum;
     typedef std::pair<Packet, bool> PacketDocker;
-    std::unordered_map<int, PacketDocker> pkts;
+    RingBuffer<PacketDocker, Configuration::MAX_WINDOW_SIZE> pkts; // 已发送的数据包及其是否已被确认
+    RttEstimator rtt;
+    TimerWheel timers; //所有报文的定时器，网络环境中只有一个定时器
+    std::vector<int> expired;
+    std::vector<int> ackSums; //receiveBatch中整批确认包的校验和
     inline bool inWindow(int ackNum); //判断是否在发送窗口里
+    void ackOne(int seqNum); //标记一个报文已被确认并停止它的定时器
+    bool markAcked(const Packet &ackPkt, int checkSum); //标记ACK确认的报文（包括SACK块中的报文），返回是否需要移动窗口
+    void slideWindow();
+    void retransmit(int seqNum); //超时重传一个报文并重新启动它的定时器
 public:
     bool send(const Message &message);                  //发送应用层下来的Message，由NetworkServiceSimulator调用,如果发送方成功地将Message发送到网络层，返回true;如果因为发送方处于等待正确确认状态而拒绝发送Message，则返回false
     void receive(const Packet &ackPkt);                 //接受确认Ack，将被NetworkServiceSimulator调用
     void timeoutHandler(int seqNum);                    //Timeout handler，将被NetworkServiceSimulator调用
     bool getWaitingState();
+    int sendBatch(Span<const Message> messages);
+    void receiveBatch(Span<const Packet> ackPkts); //先标记整批ACK，窗口只移动一次
+    int outstanding() { return (int)seqSpace.distance(base, nextSeqNum); } //窗口中被SACK确认过的报文也算在内
 public:
     SRRdtSender(int n = 4, int seqNumBits = 16);
     virtual ~SRRdtSender();
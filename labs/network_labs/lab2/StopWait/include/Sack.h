@@ -0,0 +1,23 @@
+#ifndef SACK_H
+#define SACK_H
+
+#include "Global.h"
+
+// SACK块，表示接收方已经缓存的一段连续报文[start, end)
+struct SackBlock {
+    int start;
+    int end;
+};
+
+// SACK块放在ACK报文的payload里："ACK\0"之后是块数，再往后是各个块（主机字节序）
+// payload为21字节时最多放下2个块，更大时与TCP选项空间一样最多4个；第一个块总是包含最近收到的那个报文（RFC 2018）
+const int SACK_COUNT_OFFSET = 4;
+const int SACK_BLOCK_OFFSET = 5;
+const int SACK_BLOCKS_FIT = (Configuration::PAYLOAD_SIZE - SACK_BLOCK_OFFSET) / sizeof(SackBlock);
+const int MAX_SACK_BLOCKS = SACK_BLOCKS_FIT < 4 ? SACK_BLOCKS_FIT : 4;
+static_assert(MAX_SACK_BLOCKS >= 1, "payload too small for a SACK block");
+
+Packet makeSackAckPkt(int ackNum, const SackBlock *blocks, int n);
+int getSackBlocks(const Packet &ackPkt, SackBlock *blocks); //返回块数，普通ACK返回0
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SEQ_BITMAP_H
+#define SEQ_BITMAP_H
+
+#include <stdint.h>
+
+// 与RingBuffer配套的接收位图，每个槽一位，记录该槽是否已缓存了报文
+// 实际使用的槽数slots可以小于CAPACITY（序号空间比窗口缓冲区还小时），必须是2的幂
+template <int CAPACITY>
+class SeqBitmap {
+    static_assert(CAPACITY >= 64 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "SeqBitmap capacity must be a power of two and at least 64");
+private:
+    uint64_t words[CAPACITY / 64];
+    const int slots;
+public:
+    explicit SeqBitmap(int n = CAPACITY) : slots(n) {
+        for (int i = 0; i < CAPACITY / 64; i++)
+            words[i] = 0;
+    }
+
+    int slot(int seq) const {
+        return (unsigned int)seq & (slots - 1);
+    }
+
+    bool test(int seq) const {
+        int i = slot(seq);
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(int seq) {
+        int i = slot(seq);
+        words[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+
+    void clear(int seq) {
+        int i = slot(seq);
+        words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    }
+
+    // 从seq开始连续置位的槽数（最多limit个），按字查找第一个0位，而不是逐位检查
+    int runLength(int seq, int limit) const {
+        return scan(seq, limit, 0);
+    }
+
+    // 从seq开始连续未置位的槽数（最多limit个）
+    int gapLength(int seq, int limit) const {
+        return scan(seq, limit, ~(uint64_t)0);
+    }
+private:
+    // 统计从seq开始、与invert取反后为1的连续位数：invert为0时数1，为全1时数0
+    int scan(int seq, int limit, uint64_t invert) const {
+        int n = 0;
+        int i = slot(seq);
+        while (n < limit) {
+            int bit = i & 63;
+            int avail = 64 - bit; // 本字内、回绕之前还剩的位数
+            if (avail > slots - i)
+                avail = slots - i;
+            uint64_t stop = ~(words[i >> 6] ^ invert) >> bit;
+            int run = stop ? __builtin_ctzll(stop) : avail;
+            if (run > avail)
+                run = avail;
+            n += run;
+            if (run < avail)
+                break;
+            i = (i + run) & (slots - 1);
+        }
+        return n < limit ? n : limit;
+    }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SEQ_NUM_H
+#define SEQ_NUM_H
+
+#include "DataStructure.h"
+#include <stdint.h>
+
+// 2^bits大小的序号空间（bits取1~32），按RFC 1982的序号算术处理回绕
+// 序号以无符号数的位模式存放在Packet的int字段里，所有运算都在uint32_t上进行后再与mask取模，
+// 所以32位序号空间下也不会溢出，-1恰好是0的前一个序号
+class SeqSpace {
+private:
+    const uint32_t mask; // 2^bits - 1
+public:
+    explicit SeqSpace(int bits)
+        : mask((bits > 0 && bits < 32) ? ((uint32_t)1 << bits) - 1 :
+               (bits == 32) ? 0xffffffffu : 0xffffu) {
+    }
+
+    int next(int seq) const {
+        return (int)(((uint32_t)seq + 1) & mask);
+    }
+
+    int add(int seq, uint32_t n) const {
+        return (int)(((uint32_t)seq + n) & mask);
+    }
+
+    // 从from向前数到to的距离，即(to - from) mod 2^bits
+    uint32_t distance(int from, int to) const {
+        return ((uint32_t)to - (uint32_t)from) & mask;
+    }
+
+    // seq是否落在[start, start + len)中
+    bool inRange(int seq, int start, uint32_t len) const {
+        return distance(start, seq) < len;
+    }
+
+    // 环形缓冲区实际用到的槽数：序号空间比容量小时，只用序号空间那么多的槽
+    int slots(int capacity) const {
+        return mask < (uint32_t)capacity - 1 ? (int)(mask + 1) : capacity;
+    }
+
+    // 合法的窗口大小：GBN最多2^bits - 1，SR最多2^(bits-1)，同时不超过窗口缓冲区
+    // 过大的n压到上限；命令行参数由ProtocolRegistry::maxWindow先检查并报错，这里只是兜底
+    int window(int n, bool selective) const {
+        uint32_t limit = selective ? mask / 2 + 1 : mask;
+        if (limit > (uint32_t)Configuration::MAX_WINDOW_SIZE)
+            limit = Configuration::MAX_WINDOW_SIZE;
+        if (n <= 0 || (uint32_t)n > limit)
+            return (int)limit;
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef SIM_TOOL_H
+#define SIM_TOOL_H
+
+#include "Tool.h"
+#include <stdint.h>
+
+// xorshift64*伪随机数发生器：状态只有8字节，每次调用几条整数指令，给定种子时结果可复现
+struct SimRandom {
+    uint64_t state;
+
+    explicit SimRandom(uint64_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint64_t seed) {
+        //splitmix64打散种子，避免相近的种子产生相关的序列；状态不能为0
+        uint64_t z = seed + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        state = (z ^ (z >> 31)) | 1;
+    }
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+
+    // [0, 1)上的均匀分布，取高53位
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// 工具类的源码实现，与libnetsim.a中的Utils行为一致：打印格式相同，校验和为16位反码和
+// 默认用当前时间作随机数种子，setSeed后可以复现同一次仿真
+class SimTool : public Tool {
+private:
+    SimRandom rng;
+public:
+    SimTool();
+    virtual ~SimTool();
+    void printPacket(const char *description, const Packet &packet);
+    int calculateCheckSum(const Packet &packet);
+    double random();
+    void setSeed(uint64_t seed) { rng.setSeed(seed); }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <stddef.h>
+
+// 指向一段连续元素的视图，不持有元素，相当于C++20的std::span；项目按C++11编译，所以自己定义
+template <typename T>
+class Span {
+private:
+    T *ptr;
+    size_t len;
+public:
+    Span() : ptr(nullptr), len(0) {}
+    Span(T *p, size_t n) : ptr(p), len(n) {}
+    template <size_t N>
+    Span(T (&a)[N]) : ptr(a), len(N) {}
+
+    T *data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    T &operator[](size_t i) const { return ptr[i]; }
+    T *begin() const { return ptr; }
+    T *end() const { return ptr + len; }
+    Span first(size_t n) const { return Span(ptr, n < len ? n : len); }
+    Span subspan(size_t offset) const {
+        return offset < len ? Span(ptr + offset, len - offset) : Span(ptr + len, 0);
+    }
+};
+
+#endif
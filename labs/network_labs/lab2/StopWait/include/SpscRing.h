@@ -0,0 +1,112 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+
+// 单生产者单消费者的无锁环形队列：只有一个线程调用生产者一侧（writable/commit/push），
+// 只有一个线程调用消费者一侧（readable/consume/pop/empty）
+// head、tail单调递增，下标取低位，所以容量是2的幂；两端各缓存一份对方的位置，只在看起来满或空时才读对方的原子变量
+// 除了逐个push/pop，还可以直接拿到一段连续的空位或元素，sendmmsg/recvmmsg可以在环里原地读写，不再多拷贝一次
+// reset只能在没有线程使用队列时调用
+template <typename T>
+class SpscRing {
+private:
+    static const size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+    char pad0[CACHE_LINE];
+    std::atomic<size_t> tail; //生产者写，消费者读
+    size_t cachedHead; //生产者看到的head
+    char pad1[CACHE_LINE];
+    std::atomic<size_t> head; //消费者写，生产者读
+    size_t cachedTail; //消费者看到的tail
+    char pad2[CACHE_LINE];
+public:
+    SpscRing() : mask(0), tail(0), cachedHead(0), head(0), cachedTail(0) {}
+    explicit SpscRing(size_t capacity) : SpscRing() { reset(capacity); }
+
+    // 清空队列，容量向上取到2的幂
+    void reset(size_t capacity) {
+        size_t n = 1;
+        while (n < capacity) {
+            n <<= 1;
+        }
+        slots.assign(n, T());
+        mask = n - 1;
+        tail.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+        cachedHead = cachedTail = 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    /* ---------- 生产者 ---------- */
+
+    // 从first开始的连续空位数，不超过环尾；写好之后用commit发布
+    size_t writable(T *&first) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t index = t & mask;
+        size_t contiguous = capacity() - index;
+        size_t free = capacity() - (t - cachedHead);
+        if (free < contiguous) {
+            cachedHead = head.load(std::memory_order_acquire);
+            free = capacity() - (t - cachedHead);
+        }
+        first = &slots[index];
+        return free < contiguous ? free : contiguous;
+    }
+
+    void commit(size_t n) {
+        tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    bool push(const T &value) {
+        T *slot;
+        if (writable(slot) == 0) {
+            return false;
+        }
+        *slot = value;
+        commit(1);
+        return true;
+    }
+
+    /* ---------- 消费者 ---------- */
+
+    // 从first开始的连续元素数，不超过环尾；处理完之后用consume释放
+    size_t readable(T *&first) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t index = h & mask;
+        size_t contiguous = capacity() - index;
+        size_t ready = cachedTail - h;
+        if (ready < contiguous) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            ready = cachedTail - h;
+        }
+        first = &slots[index];
+        return ready < contiguous ? ready : contiguous;
+    }
+
+    void consume(size_t n) {
+        head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    bool pop(T &value) {
+        T *slot;
+        if (readable(slot) == 0) {
+            return false;
+        }
+        value = *slot;
+        consume(1);
+        return true;
+    }
+
+    bool empty() {
+        T *first;
+        return readable(first) == 0;
+    }
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef STATS_COLLECTOR_H
+#define STATS_COLLECTOR_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <deque>
+#include <vector>
+
+// 消息时延直方图：对数-线性分桶（每个2的幂区间再分SUB个桶），百分位数的相对误差不超过1/SUB，内存与样本个数无关
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 3;
+    static const int SUB = 1 << SUB_BITS;
+    static const int SCALE = 64; //分辨率为1/SCALE个时间单位
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB;
+    long counts[BUCKETS];
+    long total;
+    double sum;
+    double maxValue;
+    static int bucketOf(double value);
+    static double lowerBound(int bucket);
+public:
+    LatencyHistogram() { clear(); }
+    void clear();
+    void add(double value);
+    long count() const { return total; }
+    double mean() const { return total ? sum / total : 0; }
+    double max() const { return maxValue; }
+    double percentile(double p) const; //p在0到1之间，返回所在桶的中点
+    void print(FILE *out) const; //每个2的幂区间一行
+};
+
+// 一次运行的详细统计：有效吞吐量、重传比例、确认效率、每个消息从交给发送方到递交给应用层的时延，以及发送窗口占用随时间的变化。
+// 由网络环境在相应的时刻调用，结束时打印；时延按消息交给发送方的顺序与递交顺序一一对应，协议按序递交时是准确的
+class StatsCollector {
+private:
+    static const int SERIES = 64; //窗口占用的时间序列最多保留这么多段，超过时相邻两段合并、每段时长加倍
+
+    long submitted;
+    long delivered;
+    long dataPackets;
+    long ackPackets;
+    std::deque<double> pending; //已交给发送方、还没有递交的消息的提交时刻
+    long unmatched; //递交时没有对应的提交记录，比如协议重复递交
+    LatencyHistogram latency;
+    double firstSubmit;
+    double lastDelivery;
+
+    bool hasOccupancy; //发送方是否报告窗口占用
+    int occupancy;
+    int maxOccupancy;
+    double lastTime; //窗口占用积分到的时刻
+    double period; //时间序列每段的时长
+    std::vector<double> series; //每段的占用积分
+    double integral;
+    void advance(double t);
+public:
+    StatsCollector() { clear(); }
+    void clear();
+
+    void onSubmit(double t, long n = 1); //发送方接受了n个消息
+    void onDeliver(double t);
+    void onData() { dataPackets++; } //发送方交给网络层一个数据报文（包括重传）
+    void onAck() { ackPackets++; }
+    void onOccupancy(double t, int outstanding); //发送方窗口中的报文数，负数表示发送方不报告
+    void finish(double t); //窗口占用积分到t
+
+    long getDelivered() const { return delivered; }
+    double goodput() const; //每个时间单位递交的消息个数，从第一个消息提交算起
+    double retransmissionRatio() const; //重传的报文占数据报文的比例
+    double messagesPerAck() const; //每个确认报文平均确认了几个消息
+    double meanOccupancy() const;
+    const LatencyHistogram &getLatency() const { return latency; }
+
+    void print(FILE *out, int payloadSize) const;
+};
+
+#endif
@@ -2,18 +2,28 @@
 #define TCP_RDT_RECEIVER_H
 
 #include "RdtReceiver.h"
-#include <unordered_map>
+#include "DelayedAck.h"
+#include "RingBuffer.h"
+#include "Sack.h"
+#include "SeqBitmap.h"
+#include "SeqNum.h"
 
 class TCPRdtReceiver : public RdtReceiver {
 private:
-    const unsigned int MAX_SEQ;
+    const SeqSpace seqSpace; //序号空间
+    const int N; //接收缓冲区能容纳的报文数，为1时只接收按序到达的报文
     int expectedSeqNum;
     Packet lastAckPkt;
+    RingBuffer<Packet, Configuration::MAX_WINDOW_SIZE> cache; // 按received.slot(seq)存放的乱序报文
+    SeqBitmap<Configuration::MAX_WINDOW_SIZE> received;
+    DelayedAck delayedAck;
+    int sackBlocks(int latest, SackBlock *blocks) const; //按缓存情况生成SACK块，latest为最近收到的报文
 public:
-    TCPRdtReceiver(int seqNumBits = 16);
+    TCPRdtReceiver(int seqNumBits = 16, int n = 1, const AckPolicy &ack = AckPolicy());
     virtual ~TCPRdtReceiver();
 public:
     void receive(const Packet &packet); //接收报文，将被NetworkService调用
+    void timeoutHandler(int seqNum); //延迟确认定时器到时，发出推迟的确认
 };
 
 #endif
\ No newline at end of file
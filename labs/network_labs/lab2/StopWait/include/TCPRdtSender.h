@@ -2,24 +2,73 @@
 #define TCP_RDT_SENDER_H
 
 #include "RdtSender.h"
-#include <unordered_map>
+#include "RingBuffer.h"
+#include "RttEstimator.h"
+#include "Sack.h"
+#include "SeqBitmap.h"
+#include "SeqNum.h"
+#include <functional>
+#include <vector>
 
+// 带Reno/NewReno拥塞控制的TCP发送方：慢启动、拥塞避免、快速重传/快速恢复，
+// 快速恢复中的部分确认按NewReno立即重传下一个丢失的报文。窗口以报文个数为单位，
+// 实际发送窗口为min(cwnd, N)，N相当于接收方通告窗口。
+// 启用SACK时按RFC 6675维护记分板：用pipe（估计的在途报文数）代替窗口膨胀/收缩，只重传记分板上的空洞
 class TCPRdtSender : public RdtSender {
+public:
+    // cwnd或ssthresh变化时的回调，用于按仿真时间记录拥塞窗口曲线
+    typedef std::function<void(double cwnd, int ssthresh)> CwndObserver;
 private:
-    const unsigned int MAX_SEQ; //最大序列号+1
+    static const int DUP_ACK_THRESHOLD = 3;
+    const SeqSpace seqSpace; //序号空间
     const int N; //窗口大小
     int base;
-    int nextSeqNum;
-    int cnt;
+    int nextSeqNum; //下一个新报文的序号，即已发送过的最大序号+1
+    int sndNxt; //下一个要（重新）发送的序号，超时后回退到base
+    int cnt; //重复ACK个数
     int lastAckNum;
-    std::unordered_map<int, Packet> pkts; //已发送并等待Ack的数据包
+    double cwnd; //拥塞窗口
+    int ssthresh; //慢启动阈值
+    bool inRecovery; //是否处于快速恢复
+    int recover; //进入快速恢复（或超时）时的nextSeqNum，确认到这里才算恢复完成
+    CwndObserver observer;
+    const bool sackEnabled;
+    SeqBitmap<Configuration::MAX_WINDOW_SIZE> sacked; //记分板：被SACK块确认过的报文
+    SeqBitmap<Configuration::MAX_WINDOW_SIZE> rexmitted; //记分板：highSacked以下已经重传过的报文
+    int highSacked; //被SACK的最大序号+1，没有时等于base
+    int rexmitCount; //rexmitted中仍在途的报文数
+    int holeCursor; //快速恢复中下一个要检查的空洞
+    bool sackRecovery; //本次快速恢复是否按记分板进行（接收方没有发SACK块时仍按NewReno）
+    RttEstimator rtt;
+    RingBuffer<Packet, Configuration::MAX_WINDOW_SIZE> pkts; //已发送并等待Ack的数据包
+    bool batching; //正在receiveBatch中，新的确认只记下要重启定时器
+    bool timerPending;
+    std::vector<int> ackSums; //receiveBatch中整批确认包的校验和
+    int window() const; //当前允许在途的报文数
+    int flightSize() const; //已发送未确认的报文数
+    int pipe() const; //估计仍在网络中的报文数，未启用SACK时等于flightSize()
+    bool belowHighSacked(int seq) const;
+    void updateScoreboard(int oldBase, const Packet &ackPkt);
+    void retransmitHoles(); //在pipe允许的范围内重传记分板上的空洞，然后继续发送
+    void transmit(); //在窗口允许的范围内发送sndNxt到nextSeqNum之间的报文
+    void retransmit(int seq);
+    void enterLossState(); //把ssthresh设为在途报文数的一半
+    void notifyCwnd();
+    void restartTimer(); //新的确认到达，为剩下的未确认报文重新计时
+    void processAck(const Packet &ackPkt, int checkSum); //checkSum是pUtils算出的校验和
 public:
     bool send(const Message &message);                  // 发送应用层下来的Message，由NetworkServiceSimulator调用,如果发送方成功地将Message发送到网络层，返回true;如果因为发送方处于等待正确确认状态而拒绝发送Message，则返回false
     void receive(const Packet &ackPkt);                 // 接受确认Ack，将被NetworkServiceSimulator调用
     void timeoutHandler(int seqNum);                    // Timeout handler，将被NetworkServiceSimulator调用
     bool getWaitingState();
+    int sendBatch(Span<const Message> messages); //按当前窗口一次接受多个报文，只调用一次transmit
+    void receiveBatch(Span<const Packet> ackPkts); //重复ACK计数需要逐个处理，但定时器只在最后重启一次
+    int outstanding() { return (int)seqSpace.distance(base, nextSeqNum); }
+    void setCwndObserver(const CwndObserver &fn);
+    double getCwnd() const { return cwnd; }
+    int getSsthresh() const { return ssthresh; }
 public:
-    TCPRdtSender(int n = 4, int seqNumBits = 16);
+    TCPRdtSender(int n = 4, int seqNumBits = 16, bool sack = true);
     virtual ~TCPRdtSender();
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "Global.h"
+#include "RingBuffer.h"
+#include "RttEstimator.h"
+#include <vector>
+
+// 发送方的哈希时间轮：每个报文的超时时间只记在轮上，网络环境里始终只有一个定时器(SENDER, TIMER_ID)，
+// 设为最早的到期时间。启动、停止一个报文的定时器都是O(1)的链表操作，不随窗口变大而变慢。
+// 每个轮槽对应一个时间单位，超过SLOTS个时间单位的超时时间绕轮一圈以上，到期前留在槽里。
+// 底层定时器只接受整数时长，报文的重传最多推迟不到一个时间单位，但不会提前。
+// 最早的报文被确认时底层定时器改设到剩下的最早到期时间，网络环境统计的每次超时都有报文到期。
+// 网络环境不提供时钟（预编译的libnetsim.a）时底层定时器每个时间单位到时一次，以到时次数作为时间。
+// 注意网络环境统计的超时次数此时是底层定时器的到时次数，不再等于超时重传的报文个数
+// 节点按槽位（id对窗口上限取模）存放和链接，id可以是任意整数，包括32位序号回绕前的0xFFFFFFFF（即-1）
+class TimerWheel {
+private:
+    static const int NIL = -1; //空链表，槽位都不小于0
+    static const int SLOTS = 256; //轮槽个数，每个轮槽一个时间单位
+    struct Node {
+        int id; //占用这个节点的id
+        bool running; //是否在轮上，空闲与否不能用id表示，任何整数都可能是序号
+        int prev; //同一轮槽中的前后节点，存的是槽位
+        int next;
+        long tick; //到期时间向下取整，决定所在的轮槽
+        double deadline;
+    };
+
+    RingBuffer<Node, Configuration::MAX_WINDOW_SIZE> nodes; //以id为下标，同时运行的id不能超过窗口上限
+    int heads[SLOTS]; //每个轮槽中按到期时间排序的链表的第一个和最后一个节点的槽位
+    int tails[SLOTS];
+    int count;
+    long cursor; //不晚于任何在轮上的节点的tick，rearm、dueBy和expire都从这里往后找
+    bool armed; //底层定时器是否在运行
+    double armedAt; //底层定时器的到时时刻
+    double ticks; //没有时钟时，上一次到时的逻辑时间
+    const SimClock *clock;
+    bool clockResolved;
+
+    double now();
+    static int slotOf(int id) { return (unsigned int)id & (Configuration::MAX_WINDOW_SIZE - 1); }
+    void link(int slot);
+    void unlink(int slot);
+    void arm(double at); //让底层定时器在at（或者之后最近的整数时长）到时
+    void rearm(); //按剩下的最早到期时间重新设置底层定时器
+    bool dueBy(double at) const; //at之前是否有报文到期，找到一个就返回
+public:
+    static const int TIMER_ID = -1; //底层定时器的编号，使用时间轮的发送方不再启动别的发送方定时器
+
+    TimerWheel();
+    void start(int id, int timeout); //已经在运行的定时器重新开始计时
+    void stop(int id);
+    bool isRunning(int id) const { return nodes[id].running && nodes[id].id == id; }
+    int size() const { return count; }
+    // 底层定时器到时：把到期的id按到期时间的先后放进expired，已经从轮上删掉，调用方重传后再start
+    void expire(std::vector<int> &expired);
+};
+
+#endif
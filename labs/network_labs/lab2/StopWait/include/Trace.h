@@ -0,0 +1,35 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "Global.h"
+#include <stdio.h>
+
+/**
+	协议的调试输出。编译时定义RDT_QUIET后TRACE_ENABLED为0，
+	所有跟踪语句（包括参数求值）都会被编译器整体去掉，没有任何运行时开销
+*/
+#ifdef RDT_QUIET
+#define TRACE_ENABLED 0
+#else
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE(...)                           \
+	do {                                 \
+		if (TRACE_ENABLED)           \
+			printf(__VA_ARGS__); \
+	} while (0)
+
+#define TRACE_PACKET(description, packet)                       \
+	do {                                                    \
+		if (TRACE_ENABLED)                              \
+			pUtils->printPacket(description, packet); \
+	} while (0)
+
+#define TRACE_FLUSH()                  \
+	do {                           \
+		if (TRACE_ENABLED)     \
+			fflush(stdout); \
+	} while (0)
+
+#endif
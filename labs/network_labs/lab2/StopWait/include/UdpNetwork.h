@@ -0,0 +1,199 @@
+#ifndef UDP_NETWORK_H
+#define UDP_NETWORK_H
+
+#include "Global.h"
+#include "Channel.h"
+#include "EventQueue.h"
+#include "NetworkSimulator.h"
+#include "RttEstimator.h"
+#include "SpscRing.h"
+#include "WirePacket.h"
+#include <atomic>
+#include <netinet/in.h>
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+
+// UDP网络环境的参数
+struct UdpConfig {
+    unsigned short port[2]; //两端绑定的回环端口，下标为RandomEventTarget；0表示由系统分配
+    int timeUnitUs; //协议中的一个时间单位（定时器时长、RTT）对应的微秒数
+    int socketBuffer; //套接字收发缓冲区大小，回环上突发发送时太小会丢包
+    double idleSeconds; //这么长时间没有任何报文和定时器事件就认为传输卡死，放弃运行
+    bool impair; //是否经过损伤层：按channel给出的参数在发送端丢包、损坏、延迟、重排、复制，时间以timeUnitUs为单位
+    ChannelConfig channel[2]; //下标为接收报文的一方，与SimConfig相同
+    bool pipeline; //应用读写、协议处理、套接字收发分别在三个线程中进行，线程之间用SPSC环形队列传递消息和报文
+    int ringSize; //pipeline时每个环形队列的容量（消息或报文个数）
+
+    UdpConfig()
+        : timeUnitUs(1000)
+        , socketBuffer(4 << 20)
+        , idleSeconds(5)
+        , impair(false)
+        , pipeline(false)
+        , ringSize(1024)
+    {
+        port[SENDER] = port[RECEIVER] = 0;
+        //损伤层的默认值是一条无损、无时延的链路，需要哪种损伤就单独设置
+        ChannelConfig clean;
+        clean.lossRate = 0;
+        clean.corruptRate = 0;
+        clean.minDelay = 0;
+        clean.jitter = 0;
+        channel[SENDER] = channel[RECEIVER] = clean;
+    }
+};
+
+// 一次运行的统计，时间为挂钟时间和本进程的CPU时间
+struct UdpStats {
+    long messages;
+    long dataPackets;
+    long ackPackets;
+    long impairLost; //被损伤层丢掉的报文
+    long impairCorrupted;
+    long sendDropped; //sendto失败（缓冲区满）而丢掉的报文
+    long received; //从套接字收到的报文
+    long delivered;
+    long timeouts;
+    double wallSeconds;
+    double userSeconds;
+    double systemSeconds;
+
+    UdpStats() { clear(); }
+    void clear() {
+        messages = dataPackets = ackPackets = 0;
+        impairLost = impairCorrupted = sendDropped = received = 0;
+        delivered = timeouts = 0;
+        wallSeconds = userSeconds = systemSeconds = 0;
+    }
+};
+
+// 用真实的UDP套接字实现NetworkService：发送方和接收方各有一个绑定在127.0.0.1上的非阻塞套接字，
+// 在同一个线程里用epoll等待两个套接字和一个timerfd。所有定时器和损伤层延迟发送的报文放在一个堆里，
+// timerfd只设置为堆顶的到期时间；stopTimer与NetworkSimulator一样只从定时器表中删除
+// 收发都按批进行：一轮事件处理中发出的报文攒起来用sendmmsg发送，接收用recvmmsg，发给发送方的确认包整批交给receiveBatch
+// 报文以WirePacket的格式发送：在sendToNetworkLayer里编码一次，之后在held、outbox和套接字之间都按字节整块复制
+// pipeline模式下分成三个线程：应用线程从MessageSource读消息、把递交的消息写进MessageSink；
+// 协议线程（调用start的线程）运行发送方和接收方、定时器和损伤层，负责报文的封装、校验和与编解码；
+// I/O线程只做sendmmsg/recvmmsg，直接在环形队列里原地收发。pns是线程局部的，协议只在协议线程里被调用
+class UdpNetwork : public NetworkService, public SimClock {
+private:
+    enum EventKind { TIMEOUT, DEPARTURE };
+    enum Stage { APP_STAGE, PROTOCOL_STAGE, IO_STAGE, STAGES };
+    // 线程没事可做时在eventfd上等待；生产者只在对方声明要睡眠时才写eventfd，忙的时候不做系统调用
+    struct Doorbell {
+        int fd;
+        std::atomic<bool> sleeping;
+        Doorbell() : fd(-1), sleeping(false) {}
+        void ring(); //生产者发布数据之后调用，对方正要睡眠时叫醒它
+        void force(); //无条件叫醒
+        void prepareSleep(); //之后再检查一次队列，仍然没事可做才等待fd
+        void wake(); //等待结束
+    };
+    struct Event {
+        double time; //以协议时间单位计
+        uint64_t order;
+        int kind;
+        RandomEventTarget target;
+        int seqNum;
+        int slot; //DEPARTURE：报文在held中的下标
+    };
+
+    UdpConfig config;
+    SimRandom rng;
+    int runMode;
+    RdtSender *sender;
+    RdtReceiver *receiver;
+    const char *inputFile;
+    const char *outputFile;
+    MessageSource *source;
+    MessageSink *sink;
+    MessageFeeder feeder;
+
+    int sock[2]; //下标为RandomEventTarget，是这一端自己的套接字
+    sockaddr_in addr[2];
+    int epollFd;
+    int timerFd;
+    double armedAt; //timerfd当前设置的到期时间，<0表示未设置
+    struct timespec startTime;
+
+    Channel channels[2];
+    EventQueue<Event> events;
+    std::vector<WirePacket> held; //损伤层延迟发送的报文
+    std::vector<int> freeSlots;
+    std::vector<WirePacket> outbox[2]; //等待用sendmmsg一起发出的报文，下标为接收报文的一方
+    std::vector<WirePacket> inbox; //recvmmsg的接收缓冲区
+    std::vector<Packet> decoded; //inbox中的报文转换成Packet后交给协议
+    std::unordered_map<uint64_t, uint64_t> timers;
+    UdpStats stats;
+    StatsCollector detail;
+    bool collectRequested;
+    bool collecting;
+
+    SpscRing<Message> appIn; //应用线程读到的消息 -> 协议线程
+    SpscRing<Message> appOut; //协议线程递交的消息 -> 应用线程
+    SpscRing<WirePacket> txRing[2]; //协议线程 -> I/O线程，下标为接收报文的一方
+    SpscRing<WirePacket> rxRing[2]; //I/O线程 -> 协议线程，下标为收到报文的一方
+    Doorbell bells[STAGES];
+    int ioEpollFd;
+    std::atomic<bool> sourceDone; //应用线程已经读完MessageSource
+    std::atomic<bool> stopping;
+    bool pending[STAGES]; //协议线程本轮往该线程的队列里放了数据，flush时通知
+    long lastFed; //上一次feed被发送方接受的消息数
+
+    static uint64_t timerKey(RandomEventTarget target, int seqNum) {
+        return ((uint64_t)target << 32) | (uint32_t)seqNum;
+    }
+    bool verbose() const { return runMode == 0; }
+    bool pipelined() const { return config.pipeline; }
+    bool open();
+    void close();
+    void transmit(RandomEventTarget target, const WirePacket &pkt);
+    void flush(RandomEventTarget target);
+    void flush();
+    void dispatch(RandomEventTarget target, int n);
+    void drain(RandomEventTarget target);
+    void drainRing(RandomEventTarget target);
+    void expire();
+    void armTimer();
+    void feed();
+    bool finished() const;
+    bool hasWork();
+    void run();
+    void runPipelined();
+    void appLoop();
+    void ioLoop();
+    bool ioSend(RandomEventTarget target);
+    int ioReceive(RandomEventTarget target);
+    void printStats();
+public:
+    UdpNetwork();
+    virtual ~UdpNetwork();
+
+    void startTimer(RandomEventTarget target, int timeOut, int seqNum);
+    void stopTimer(RandomEventTarget target, int seqNum);
+    void sendToNetworkLayer(RandomEventTarget target, Packet pkt);
+    void delivertoAppLayer(RandomEventTarget target, Message msg);
+
+    void init();
+    void start();
+    void setRtdSender(RdtSender *ps);
+    void setRtdReceiver(RdtReceiver *pr);
+    void setInputFile(const char *ifile);
+    void setOutputFile(const char *ofile);
+    void setRunMode(int mode = 0);
+
+    double now() const; //从start开始经过的协议时间单位
+
+    void setConfig(const UdpConfig &c) { config = c; }
+    const UdpConfig &getConfig() const { return config; }
+    void setSeed(uint64_t seed) { rng.setSeed(seed); }
+    void setMessageSource(MessageSource *s) { source = s; }
+    void setMessageSink(MessageSink *s) { sink = s; }
+    const UdpStats &getStats() const { return stats; }
+    // 与NetworkSimulator相同：runMode不为2时总是收集并打印，时延以协议时间单位计
+    void setCollectStats(bool on) { collectRequested = on; }
+    const StatsCollector &getDetailedStats() const { return detail; }
+};
+
+#endif
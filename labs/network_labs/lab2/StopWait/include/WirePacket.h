@@ -0,0 +1,84 @@
+#ifndef WIRE_PACKET_H
+#define WIRE_PACKET_H
+
+#include "DataStructure.h"
+#include "Span.h"
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// 报文在线路上的格式：12字节报文头（序号、确认号、校验和，均为32位大端）紧跟payload，没有填充
+// Packet带有虚函数表指针，不能按内存原样发送、memcpy或放进共享内存；WirePacket是标准布局、可平凡复制的，
+// 可以整批放在环形缓冲区里并直接交给sendmmsg/recvmmsg。与Packet之间的转换由下面的适配函数完成，协议代码仍然使用Packet
+struct WireHeader {
+    unsigned char seqnum[4];
+    unsigned char acknum[4];
+    unsigned char checksum[4];
+};
+
+struct WirePacket {
+    WireHeader header;
+    char payload[Configuration::PAYLOAD_SIZE];
+
+    static const int HEADER_SIZE = sizeof(WireHeader);
+    static const int SIZE = HEADER_SIZE + Configuration::PAYLOAD_SIZE;
+
+    WirePacket() = default;
+    explicit WirePacket(const Packet &pkt) { encode(pkt); }
+
+    int seqnum() const { return get32(header.seqnum); }
+    int acknum() const { return get32(header.acknum); }
+    int checksum() const { return get32(header.checksum); }
+
+    void encode(const Packet &pkt) {
+        put32(header.seqnum, pkt.seqnum);
+        put32(header.acknum, pkt.acknum);
+        put32(header.checksum, pkt.checksum);
+        memcpy(payload, pkt.payload, sizeof(payload));
+    }
+
+    void decode(Packet &pkt) const {
+        pkt.seqnum = seqnum();
+        pkt.acknum = acknum();
+        pkt.checksum = checksum();
+        memcpy(pkt.payload, payload, sizeof(payload));
+    }
+
+    Packet toPacket() const {
+        Packet pkt;
+        decode(pkt);
+        return pkt;
+    }
+
+private:
+    static void put32(unsigned char *p, int v) {
+        uint32_t u = (uint32_t)v;
+        p[0] = (unsigned char)(u >> 24);
+        p[1] = (unsigned char)(u >> 16);
+        p[2] = (unsigned char)(u >> 8);
+        p[3] = (unsigned char)u;
+    }
+    static int get32(const unsigned char *p) {
+        return (int)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+                     ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+    }
+};
+
+static_assert(std::is_standard_layout<WirePacket>::value, "WirePacket must be standard layout");
+static_assert(std::is_trivially_copyable<WirePacket>::value, "WirePacket must be trivially copyable");
+static_assert(sizeof(WirePacket) == WirePacket::SIZE, "WirePacket must not contain padding");
+
+// 整批转换，out至少有in.size()个元素
+inline void encodePackets(Span<const Packet> in, WirePacket *out) {
+    for (size_t i = 0; i < in.size(); i++) {
+        out[i].encode(in[i]);
+    }
+}
+
+inline void decodePackets(Span<const WirePacket> in, Packet *out) {
+    for (size_t i = 0; i < in.size(); i++) {
+        in[i].decode(out[i]);
+    }
+}
+
+#endif
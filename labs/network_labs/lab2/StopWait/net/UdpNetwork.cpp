@@ -0,0 +1,915 @@
+#include "../include/UdpNetwork.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <thread>
+#include <unistd.h>
+
+#define UDP_PREFIX "******UDP网络环境******："
+
+static const uint32_t TIMER_TAG = 2; //epoll事件中timerfd的标记，套接字用RandomEventTarget作标记
+static const uint32_t BELL_TAG = 3; //pipeline模式下本线程Doorbell的eventfd
+static const int EPOLL_WAIT_MS = 100;
+static const int IO_BATCH = 64; //一次sendmmsg/recvmmsg的最大报文数
+static_assert(WirePacket::SIZE <= 65507, "WirePacket does not fit in a UDP datagram");
+
+static RandomEventTarget peer(RandomEventTarget target)
+{
+	return target == SENDER ? RECEIVER : SENDER;
+}
+
+static double elapsed(const struct timespec &from, const struct timespec &to)
+{
+	return (to.tv_sec - from.tv_sec) + (to.tv_nsec - from.tv_nsec) * 1e-9;
+}
+
+static double cpuSeconds(const struct timeval &tv)
+{
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// pipeline模式下协议线程从appIn取消息：只报告队列里现有的，读完整个输入由sourceDone表示
+struct RingSource : public MessageSource {
+	SpscRing<Message> &ring;
+
+	explicit RingSource(SpscRing<Message> &r)
+		: ring(r)
+	{
+	}
+
+	bool hasMore()
+	{
+		return !ring.empty();
+	}
+
+	void next(Message &msg)
+	{
+		ring.pop(msg);
+	}
+};
+
+/* ---------------- Doorbell ---------------- */
+
+// 与睡眠一方的"先置sleeping再检查队列"配对：两边各有一个seq_cst屏障，
+// 所以要么这里看到sleeping，要么对方检查队列时看到新数据
+void UdpNetwork::Doorbell::ring()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.load(std::memory_order_relaxed)) {
+		force();
+	}
+}
+
+void UdpNetwork::Doorbell::force()
+{
+	uint64_t one = 1;
+	ssize_t r = write(fd, &one, sizeof(one));
+	(void)r;
+}
+
+void UdpNetwork::Doorbell::prepareSleep()
+{
+	sleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void UdpNetwork::Doorbell::wake()
+{
+	sleeping.store(false, std::memory_order_relaxed);
+	uint64_t count;
+	ssize_t r = read(fd, &count, sizeof(count)); //非阻塞，清掉积累的通知
+	(void)r;
+}
+
+/* ---------------- UdpNetwork ---------------- */
+
+UdpNetwork::UdpNetwork()
+	: rng((uint64_t)time(nullptr))
+	, runMode(0)
+	, sender(nullptr)
+	, receiver(nullptr)
+	, inputFile(nullptr)
+	, outputFile(nullptr)
+	, source(nullptr)
+	, sink(nullptr)
+	, epollFd(-1)
+	, timerFd(-1)
+	, armedAt(-1)
+	, inbox(IO_BATCH)
+	, decoded(IO_BATCH)
+	, collectRequested(false)
+	, collecting(false)
+	, ioEpollFd(-1)
+	, sourceDone(false)
+	, stopping(false)
+	, lastFed(0)
+{
+	sock[SENDER] = sock[RECEIVER] = -1;
+	pending[APP_STAGE] = pending[PROTOCOL_STAGE] = pending[IO_STAGE] = false;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+}
+
+UdpNetwork::~UdpNetwork()
+{
+	close();
+}
+
+void UdpNetwork::setRtdSender(RdtSender *ps)
+{
+	sender = ps;
+}
+
+void UdpNetwork::setRtdReceiver(RdtReceiver *pr)
+{
+	receiver = pr;
+}
+
+void UdpNetwork::setInputFile(const char *ifile)
+{
+	inputFile = ifile;
+}
+
+void UdpNetwork::setOutputFile(const char *ofile)
+{
+	outputFile = ofile;
+}
+
+void UdpNetwork::setRunMode(int mode)
+{
+	runMode = mode;
+}
+
+double UdpNetwork::now() const
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return elapsed(startTime, t) * 1e6 / config.timeUnitUs;
+}
+
+bool UdpNetwork::open()
+{
+	for (int i = 0; i < 2; i++) {
+		sock[i] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (sock[i] < 0) {
+			perror("socket");
+			return false;
+		}
+		setsockopt(sock[i], SOL_SOCKET, SO_RCVBUF, &config.socketBuffer,
+			   sizeof(config.socketBuffer));
+		setsockopt(sock[i], SOL_SOCKET, SO_SNDBUF, &config.socketBuffer,
+			   sizeof(config.socketBuffer));
+		memset(&addr[i], 0, sizeof(addr[i]));
+		addr[i].sin_family = AF_INET;
+		addr[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr[i].sin_port = htons(config.port[i]);
+		if (bind(sock[i], (sockaddr *)&addr[i], sizeof(addr[i])) < 0) {
+			perror("bind");
+			return false;
+		}
+		//端口为0时由系统分配，取回实际绑定的地址
+		socklen_t len = sizeof(addr[i]);
+		getsockname(sock[i], (sockaddr *)&addr[i], &len);
+	}
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (epollFd < 0 || timerFd < 0) {
+		perror("epoll/timerfd");
+		return false;
+	}
+	//pipeline时套接字由I/O线程等待，协议线程只等timerfd和自己的Doorbell
+	int socketEpoll = epollFd;
+	epoll_event ev;
+	if (pipelined()) {
+		ioEpollFd = epoll_create1(EPOLL_CLOEXEC);
+		if (ioEpollFd < 0) {
+			perror("epoll");
+			return false;
+		}
+		for (Doorbell &bell : bells) {
+			bell.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (bell.fd < 0) {
+				perror("eventfd");
+				return false;
+			}
+		}
+		socketEpoll = ioEpollFd;
+		ev.events = EPOLLIN;
+		ev.data.u32 = BELL_TAG;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, bells[PROTOCOL_STAGE].fd, &ev);
+		epoll_ctl(ioEpollFd, EPOLL_CTL_ADD, bells[IO_STAGE].fd, &ev);
+	}
+	for (uint32_t i = 0; i < 2; i++) {
+		ev.events = EPOLLIN;
+		ev.data.u32 = i;
+		epoll_ctl(socketEpoll, EPOLL_CTL_ADD, sock[i], &ev);
+	}
+	ev.events = EPOLLIN;
+	ev.data.u32 = TIMER_TAG;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+	armedAt = -1;
+	return true;
+}
+
+void UdpNetwork::close()
+{
+	int *fds[] = { &sock[SENDER], &sock[RECEIVER], &epollFd, &timerFd, &ioEpollFd,
+		       &bells[APP_STAGE].fd, &bells[PROTOCOL_STAGE].fd, &bells[IO_STAGE].fd };
+	for (int *fd : fds) {
+		if (*fd >= 0) {
+			::close(*fd);
+			*fd = -1;
+		}
+	}
+}
+
+void UdpNetwork::startTimer(RandomEventTarget target, int timeOut, int seqNum)
+{
+	uint64_t key = timerKey(target, seqNum);
+	if (timers.count(key)) {
+		cout << UDP_PREFIX "试图启动一个已经存在的定时器" << endl;
+		return;
+	}
+	Event e;
+	e.time = now() + timeOut;
+	e.kind = TIMEOUT;
+	e.target = target;
+	e.seqNum = seqNum;
+	e.slot = -1;
+	timers[key] = events.push(e);
+}
+
+void UdpNetwork::stopTimer(RandomEventTarget target, int seqNum)
+{
+	timers.erase(timerKey(target, seqNum));
+}
+
+void UdpNetwork::transmit(RandomEventTarget target, const WirePacket &pkt)
+{
+	if (pipelined()) {
+		//队列满时等I/O线程发出去；I/O线程从不等待协议线程，所以不会死锁
+		while (!txRing[target].push(pkt)) {
+			bells[IO_STAGE].ring();
+			sched_yield();
+		}
+		pending[IO_STAGE] = true;
+		return;
+	}
+	outbox[target].push_back(pkt);
+	if (outbox[target].size() >= (size_t)IO_BATCH) {
+		flush(target);
+	}
+}
+
+void UdpNetwork::flush(RandomEventTarget target)
+{
+	std::vector<WirePacket> &out = outbox[target];
+	mmsghdr msgs[IO_BATCH];
+	iovec iov[IO_BATCH];
+	size_t done = 0;
+	while (done < out.size()) {
+		int n = 0;
+		for (; n < IO_BATCH && done + n < out.size(); n++) {
+			iov[n].iov_base = &out[done + n];
+			iov[n].iov_len = WirePacket::SIZE;
+			memset(&msgs[n], 0, sizeof(msgs[n]));
+			msgs[n].msg_hdr.msg_name = &addr[target];
+			msgs[n].msg_hdr.msg_namelen = sizeof(addr[target]);
+			msgs[n].msg_hdr.msg_iov = &iov[n];
+			msgs[n].msg_hdr.msg_iovlen = 1;
+		}
+		int sent = sendmmsg(sock[peer(target)], msgs, n, 0);
+		if (sent <= 0) {
+			//缓冲区满时和真实网络一样丢掉这一个，由协议重传
+			stats.sendDropped++;
+			sent = 1;
+		}
+		done += sent;
+	}
+	out.clear();
+}
+
+void UdpNetwork::flush()
+{
+	if (pipelined()) {
+		//一轮事件处理结束时统一通知，而不是每放一个就检查一次
+		for (int stage : { APP_STAGE, IO_STAGE }) {
+			if (pending[stage]) {
+				bells[stage].ring();
+				pending[stage] = false;
+			}
+		}
+		return;
+	}
+	flush(RECEIVER);
+	flush(SENDER);
+}
+
+void UdpNetwork::sendToNetworkLayer(RandomEventTarget target, Packet pkt)
+{
+	(target == RECEIVER ? stats.dataPackets : stats.ackPackets)++;
+	if (collecting) {
+		if (target == RECEIVER) {
+			detail.onData();
+		} else {
+			detail.onAck();
+		}
+	}
+	if (verbose()) {
+		cout << (target == RECEIVER ? UDP_PREFIX "发送数据包：" :
+					      UDP_PREFIX "发送确认包：");
+		pkt.print();
+	}
+	if (!config.impair) {
+		transmit(target, WirePacket(pkt));
+		return;
+	}
+
+	double t = now();
+	Transmission tr = channels[target].transmit(t, pkt, rng);
+	if (tr.lost) {
+		stats.impairLost++;
+		return;
+	}
+	if (tr.corrupted) {
+		stats.impairCorrupted++;
+	}
+	WirePacket wire(pkt);
+	for (int i = 0; i < tr.copies; i++) {
+		if (tr.arrival[i] <= t) {
+			transmit(target, wire);
+			continue;
+		}
+		//到达时刻才真正发出，回环本身的时延可以忽略
+		int slot;
+		if (freeSlots.empty()) {
+			slot = (int)held.size();
+			held.push_back(wire);
+		} else {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+			held[slot] = wire;
+		}
+		Event e;
+		e.time = tr.arrival[i];
+		e.kind = DEPARTURE;
+		e.target = target;
+		e.seqNum = 0;
+		e.slot = slot;
+		events.push(e);
+	}
+}
+
+void UdpNetwork::delivertoAppLayer(RandomEventTarget, Message msg)
+{
+	if (verbose()) {
+		cout << UDP_PREFIX "向上递交给应用层数据：";
+		msg.print();
+	}
+	stats.delivered++;
+	if (collecting) {
+		detail.onDeliver(now());
+	}
+	if (pipelined()) {
+		while (!appOut.push(msg)) {
+			bells[APP_STAGE].ring();
+			sched_yield();
+		}
+		pending[APP_STAGE] = true;
+		return;
+	}
+	if (sink) {
+		sink->write(msg);
+	}
+}
+
+// 把decoded中的前n个报文交给target一方
+void UdpNetwork::dispatch(RandomEventTarget target, int n)
+{
+	Packet *pkts = decoded.data();
+	if (target == SENDER) {
+		sender->receiveBatch(Span<const Packet>(pkts, n));
+	} else {
+		for (int i = 0; i < n; i++) {
+			receiver->receive(pkts[i]);
+		}
+	}
+}
+
+void UdpNetwork::drain(RandomEventTarget target)
+{
+	WirePacket *wire = inbox.data();
+	Packet *pkts = decoded.data();
+	mmsghdr msgs[IO_BATCH];
+	iovec iov[IO_BATCH];
+	for (;;) {
+		for (int i = 0; i < IO_BATCH; i++) {
+			iov[i].iov_base = &wire[i];
+			iov[i].iov_len = WirePacket::SIZE;
+			memset(&msgs[i], 0, sizeof(msgs[i]));
+			msgs[i].msg_hdr.msg_iov = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		int n = recvmmsg(sock[target], msgs, IO_BATCH, MSG_DONTWAIT, nullptr);
+		if (n <= 0) {
+			return; //EAGAIN：已经读空
+		}
+		//长度不对的报文不是本程序发出的，直接丢掉
+		int valid = 0;
+		for (int i = 0; i < n; i++) {
+			if (msgs[i].msg_len == (unsigned int)WirePacket::SIZE &&
+			    !(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+				wire[i].decode(pkts[valid++]);
+			}
+		}
+		stats.received += valid;
+		dispatch(target, valid);
+		if (n < IO_BATCH) {
+			return;
+		}
+	}
+}
+
+// pipeline模式：I/O线程已经收好并检查过长度，这里只解码
+void UdpNetwork::drainRing(RandomEventTarget target)
+{
+	WirePacket *wire;
+	Packet *pkts = decoded.data();
+	for (;;) {
+		size_t n = rxRing[target].readable(wire);
+		if (n == 0) {
+			return;
+		}
+		if (n > (size_t)IO_BATCH) {
+			n = IO_BATCH;
+		}
+		for (size_t i = 0; i < n; i++) {
+			wire[i].decode(pkts[i]);
+		}
+		rxRing[target].consume(n);
+		dispatch(target, (int)n);
+	}
+}
+
+void UdpNetwork::expire()
+{
+	double t = now();
+	while (!events.empty() && events.top().time <= t) {
+		Event e = events.pop();
+		if (e.kind == DEPARTURE) {
+			transmit(e.target, held[e.slot]);
+			freeSlots.push_back(e.slot);
+			continue;
+		}
+		auto it = timers.find(timerKey(e.target, e.seqNum));
+		if (it == timers.end() || it->second != e.order) {
+			continue;
+		}
+		timers.erase(it);
+		if (e.target == RECEIVER) {
+			receiver->timeoutHandler(e.seqNum);
+			continue;
+		}
+		stats.timeouts++;
+		sender->timeoutHandler(e.seqNum);
+	}
+}
+
+void UdpNetwork::armTimer()
+{
+	if (events.empty() || events.top().time == armedAt) {
+		return;
+	}
+	armedAt = events.top().time;
+	double us = armedAt * config.timeUnitUs;
+	long long ns = (long long)(us * 1000) + startTime.tv_nsec;
+	itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = startTime.tv_sec + ns / 1000000000;
+	spec.it_value.tv_nsec = ns % 1000000000;
+	timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void UdpNetwork::feed()
+{
+	long n = feeder.feed(sender);
+	lastFed = n;
+	stats.messages += n;
+	if (collecting) {
+		double t = now();
+		detail.onSubmit(t, n);
+		detail.onOccupancy(t, sender->outstanding());
+	}
+}
+
+bool UdpNetwork::finished() const
+{
+	//先看sourceDone再看队列：应用线程在放完最后一批消息之后才置位
+	if (pipelined() && !sourceDone.load(std::memory_order_acquire)) {
+		return false;
+	}
+	return !feeder.hasMore() && stats.delivered >= stats.messages;
+}
+
+// 协议线程不用睡眠就有事可做：收到了报文，或者上次发送方还在接受而队列里又有了消息
+bool UdpNetwork::hasWork()
+{
+	return !rxRing[SENDER].empty() || !rxRing[RECEIVER].empty() ||
+	       (lastFed > 0 && !appIn.empty());
+}
+
+void UdpNetwork::run()
+{
+	struct timespec lastActivity;
+	clock_gettime(CLOCK_MONOTONIC, &lastActivity);
+	epoll_event ready[3];
+	feeder.reset(source);
+	feed();
+	while (!finished()) {
+		flush();
+		armTimer();
+		int n = epoll_wait(epollFd, ready, 3, EPOLL_WAIT_MS);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("epoll_wait");
+			return;
+		}
+		struct timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if (n == 0) {
+			if (elapsed(lastActivity, t) > config.idleSeconds) {
+				cout << UDP_PREFIX "长时间没有报文和定时器事件，放弃运行" << endl;
+				return;
+			}
+			continue;
+		}
+		lastActivity = t;
+		for (int i = 0; i < n; i++) {
+			if (ready[i].data.u32 == TIMER_TAG) {
+				uint64_t expirations;
+				ssize_t r = read(timerFd, &expirations, sizeof(expirations));
+				(void)r;
+				armedAt = -1;
+			} else {
+				drain((RandomEventTarget)ready[i].data.u32);
+			}
+		}
+		expire();
+		feed();
+	}
+	if (collecting) {
+		detail.finish(now());
+	}
+}
+
+void UdpNetwork::runPipelined()
+{
+	struct timespec lastActivity;
+	clock_gettime(CLOCK_MONOTONIC, &lastActivity);
+	RingSource input(appIn);
+	feeder.reset(&input);
+	sourceDone.store(false, std::memory_order_relaxed);
+	stopping.store(false, std::memory_order_relaxed);
+	std::thread app(&UdpNetwork::appLoop, this);
+	std::thread io(&UdpNetwork::ioLoop, this);
+
+	Doorbell &bell = bells[PROTOCOL_STAGE];
+	epoll_event ready[2];
+	feed();
+	while (!finished()) {
+		flush();
+		armTimer();
+		bell.prepareSleep();
+		//有事可做时不进入epoll_wait；timerfd留到下一次等待时再读，到期的定时器由expire按当前时间处理
+		bool busy = hasWork();
+		int n = busy ? 0 : epoll_wait(epollFd, ready, 2, EPOLL_WAIT_MS);
+		bell.wake();
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("epoll_wait");
+			break;
+		}
+		struct timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		if (n == 0 && !busy) {
+			if (elapsed(lastActivity, t) > config.idleSeconds) {
+				cout << UDP_PREFIX "长时间没有报文和定时器事件，放弃运行" << endl;
+				break;
+			}
+			continue;
+		}
+		lastActivity = t;
+		for (int i = 0; i < n; i++) {
+			if (ready[i].data.u32 == TIMER_TAG) {
+				uint64_t expirations;
+				ssize_t r = read(timerFd, &expirations, sizeof(expirations));
+				(void)r;
+				armedAt = -1;
+			}
+		}
+		drainRing(RECEIVER);
+		drainRing(SENDER);
+		expire();
+		feed();
+	}
+	flush();
+	stopping.store(true, std::memory_order_release);
+	bells[APP_STAGE].force();
+	bells[IO_STAGE].force();
+	app.join();
+	io.join();
+	feeder.reset(source);
+	if (collecting) {
+		detail.finish(now());
+	}
+}
+
+// 应用线程：把MessageSource读进appIn，把appOut写进MessageSink
+void UdpNetwork::appLoop()
+{
+	Doorbell &bell = bells[APP_STAGE];
+	bool reading = true;
+	for (;;) {
+		bool progress = false;
+		Message *slot;
+		if (reading) {
+			size_t room = appIn.writable(slot);
+			size_t n = 0;
+			while (n < room && source->hasMore()) {
+				source->next(slot[n++]);
+			}
+			if (n > 0) {
+				appIn.commit(n);
+				progress = true;
+			}
+			if (n < room) {
+				sourceDone.store(true, std::memory_order_release);
+				reading = false;
+			}
+			if (progress || !reading) {
+				bells[PROTOCOL_STAGE].ring();
+			}
+		}
+		size_t n = appOut.readable(slot);
+		if (n > 0) {
+			for (size_t i = 0; i < n; i++) {
+				sink->write(slot[i]);
+			}
+			appOut.consume(n);
+			progress = true;
+		}
+		if (progress) {
+			continue;
+		}
+		//协议线程在递交完所有消息之后才置stopping，所以这时appOut里已经是全部了
+		if (stopping.load(std::memory_order_acquire) && appOut.empty()) {
+			return;
+		}
+		bell.prepareSleep();
+		if (appOut.empty() && !(reading && appIn.writable(slot) > 0)) {
+			pollfd pfd;
+			pfd.fd = bell.fd;
+			pfd.events = POLLIN;
+			poll(&pfd, 1, EPOLL_WAIT_MS);
+		}
+		bell.wake();
+	}
+}
+
+// I/O线程：把txRing中的报文发出去，把收到的报文放进rxRing
+void UdpNetwork::ioLoop()
+{
+	Doorbell &bell = bells[IO_STAGE];
+	epoll_event ready[3];
+	while (!stopping.load(std::memory_order_acquire)) {
+		bool progress = false;
+		bool blocked = false;
+		for (RandomEventTarget target : { RECEIVER, SENDER }) {
+			progress |= ioSend(target);
+		}
+		for (RandomEventTarget target : { RECEIVER, SENDER }) {
+			int r = ioReceive(target);
+			progress |= r > 0;
+			blocked |= r < 0;
+		}
+		if (progress) {
+			continue;
+		}
+		if (blocked) {
+			//rxRing满了，套接字里还有报文，等协议线程取走
+			sched_yield();
+			continue;
+		}
+		bell.prepareSleep();
+		if (txRing[RECEIVER].empty() && txRing[SENDER].empty()) {
+			epoll_wait(ioEpollFd, ready, 3, EPOLL_WAIT_MS);
+		}
+		bell.wake();
+	}
+}
+
+// 直接从txRing里原地发送，返回是否发出了报文（包括因缓冲区满而丢掉的）
+bool UdpNetwork::ioSend(RandomEventTarget target)
+{
+	WirePacket *first;
+	size_t n = txRing[target].readable(first);
+	if (n == 0) {
+		return false;
+	}
+	if (n > (size_t)IO_BATCH) {
+		n = IO_BATCH;
+	}
+	mmsghdr msgs[IO_BATCH];
+	iovec iov[IO_BATCH];
+	for (size_t i = 0; i < n; i++) {
+		iov[i].iov_base = &first[i];
+		iov[i].iov_len = WirePacket::SIZE;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = &addr[target];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addr[target]);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	int sent = sendmmsg(sock[peer(target)], msgs, (unsigned int)n, 0);
+	if (sent <= 0) {
+		//与单线程时相同：缓冲区满时丢掉这一个，由协议重传；sendDropped只由I/O线程修改
+		stats.sendDropped++;
+		sent = 1;
+	}
+	txRing[target].consume(sent);
+	return true;
+}
+
+// 直接收进rxRing的空位，长度不对的报文被后面的覆盖；返回recvmmsg收到的报文数，队列满时返回-1
+int UdpNetwork::ioReceive(RandomEventTarget target)
+{
+	WirePacket *first;
+	size_t room = rxRing[target].writable(first);
+	if (room == 0) {
+		return -1;
+	}
+	if (room > (size_t)IO_BATCH) {
+		room = IO_BATCH;
+	}
+	mmsghdr msgs[IO_BATCH];
+	iovec iov[IO_BATCH];
+	for (size_t i = 0; i < room; i++) {
+		iov[i].iov_base = &first[i];
+		iov[i].iov_len = WirePacket::SIZE;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	int n = recvmmsg(sock[target], msgs, (unsigned int)room, MSG_DONTWAIT, nullptr);
+	if (n <= 0) {
+		return 0;
+	}
+	int valid = 0;
+	for (int i = 0; i < n; i++) {
+		if (msgs[i].msg_len == (unsigned int)WirePacket::SIZE &&
+		    !(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+			if (valid != i) {
+				first[valid] = first[i];
+			}
+			valid++;
+		}
+	}
+	if (valid > 0) {
+		stats.received += valid; //received只由I/O线程修改
+		rxRing[target].commit(valid);
+		bells[PROTOCOL_STAGE].ring();
+	}
+	return n;
+}
+
+void UdpNetwork::printStats()
+{
+	cout << UDP_PREFIX "已发送完应用层数据，关闭UDP网络环境" << endl;
+	cout << "已发送应用层Message个数: " << stats.messages << endl;
+	cout << "发送到网络层数据Packet个数: " << stats.dataPackets << endl;
+	cout << "发送到网络层确认Packet个数: " << stats.ackPackets << endl;
+	if (config.impair) {
+		cout << "损伤层丢失的Packet个数: " << stats.impairLost << endl;
+		cout << "损伤层损坏的Packet个数: " << stats.impairCorrupted << endl;
+	}
+	cout << "发送失败丢弃的Packet个数: " << stats.sendDropped << endl;
+	cout << "向上递交的Message个数: " << stats.delivered << endl;
+	cout << "超时次数: " << stats.timeouts << endl;
+	if (pipelined()) {
+		cout << "应用读写、协议处理、套接字收发各用一个线程，环形队列容量: " << config.ringSize << endl;
+	}
+	cout << "耗时: " << stats.wallSeconds << "s, CPU用户态 "
+	     << stats.userSeconds << "s, 内核态 " << stats.systemSeconds << "s" << endl;
+	if (collecting) {
+		cout.flush();
+		detail.print(stdout, Configuration::PAYLOAD_SIZE);
+		fflush(stdout);
+	}
+	cout << endl;
+}
+
+void UdpNetwork::init()
+{
+	if (runMode != 2) {
+		cout << UDP_PREFIX "UDP网络环境初始化..." << endl;
+	}
+}
+
+void UdpNetwork::start()
+{
+	if (sender == nullptr || receiver == nullptr) {
+		cout << UDP_PREFIX "没有设置Rdt协议实体，UDP网络环境无法启动" << endl;
+		return;
+	}
+	if ((source == nullptr && inputFile == nullptr) ||
+	    (sink == nullptr && outputFile == nullptr)) {
+		cout << UDP_PREFIX "没有设置发送或接收文件路径，UDP网络环境无法启动" << endl;
+		return;
+	}
+
+	MessageSource *ownSource = nullptr;
+	MessageSink *ownSink = nullptr;
+	if (source == nullptr) {
+		source = ownSource = openFileSource(inputFile);
+		if (source == nullptr) {
+			cout << "文件" << inputFile << "不存在. UDP网络环境无法启动\n";
+			return;
+		}
+	}
+	if (sink == nullptr) {
+		sink = ownSink = openFileSink(outputFile);
+		if (sink == nullptr) {
+			cout << "文件" << outputFile << "无法创建. UDP网络环境无法启动\n";
+			delete ownSource;
+			source = nullptr;
+			return;
+		}
+	}
+
+	if (open()) {
+		channels[SENDER].configure(config.channel[SENDER]);
+		channels[RECEIVER].configure(config.channel[RECEIVER]);
+		events.clear();
+		timers.clear();
+		held.clear();
+		freeSlots.clear();
+		outbox[SENDER].clear();
+		outbox[RECEIVER].clear();
+		stats.clear();
+		collecting = runMode != 2 || collectRequested;
+		detail.clear();
+		if (pipelined()) {
+			appIn.reset(config.ringSize);
+			appOut.reset(config.ringSize);
+			for (int i = 0; i < 2; i++) {
+				txRing[i].reset(config.ringSize);
+				rxRing[i].reset(config.ringSize);
+			}
+			pending[APP_STAGE] = pending[IO_STAGE] = false;
+		}
+		if (runMode != 2) {
+			cout << UDP_PREFIX "UDP网络环境启动，发送方端口" << ntohs(addr[SENDER].sin_port)
+			     << "，接收方端口" << ntohs(addr[RECEIVER].sin_port) << endl;
+		}
+
+		struct rusage before, after;
+		getrusage(RUSAGE_SELF, &before);
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		if (pipelined()) {
+			runPipelined();
+		} else {
+			run();
+		}
+		struct timespec end;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		getrusage(RUSAGE_SELF, &after);
+		stats.wallSeconds = elapsed(startTime, end);
+		stats.userSeconds = cpuSeconds(after.ru_utime) - cpuSeconds(before.ru_utime);
+		stats.systemSeconds = cpuSeconds(after.ru_stime) - cpuSeconds(before.ru_stime);
+		if (runMode != 2) {
+			printStats();
+		}
+	}
+	close();
+
+	if (ownSource) {
+		delete ownSource;
+		source = nullptr;
+	}
+	if (ownSink) {
+		delete ownSink;
+		sink = nullptr;
+	}
+}
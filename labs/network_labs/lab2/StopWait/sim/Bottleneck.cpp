@@ -0,0 +1,86 @@
+#include "../include/Bottleneck.h"
+#include <math.h>
+
+void BottleneckQueue::configure(const BottleneckConfig &c)
+{
+	config = c;
+	if (config.queueLimit < 1) {
+		config.queueLimit = 1;
+	}
+	minTh = c.redMinTh > 0 ? c.redMinTh : config.queueLimit / 6.0;
+	maxTh = c.redMaxTh > minTh ? c.redMaxTh : 3 * minTh;
+	departures.clear();
+	linkFree = 0;
+	avg = 0;
+	count = -1;
+	arrivals = tailDrops = earlyDrops = 0;
+	maxLength = 0;
+	lengthSum = delaySum = 0;
+}
+
+int BottleneckQueue::length(double now)
+{
+	while (!departures.empty() && departures.front() <= now) {
+		departures.pop_front();
+	}
+	return (int)departures.size();
+}
+
+bool BottleneckQueue::dropEarly(int length, double now, SimRandom &rng)
+{
+	if (length > 0) {
+		avg += config.redWeight * (length - avg);
+	} else if (config.transmissionTime > 0) {
+		//队列空闲期间按这段时间内本可以发送的报文数衰减，空闲从最后一个报文离开链路时算起
+		double idle = now - linkFree;
+		if (idle > 0) {
+			avg *= pow(1 - config.redWeight, idle / config.transmissionTime);
+		}
+	}
+	if (avg < minTh) {
+		count = -1;
+		return false;
+	}
+	if (avg >= maxTh) {
+		count = 0;
+		return true;
+	}
+	count++;
+	double pb = config.redMaxP * (avg - minTh) / (maxTh - minTh);
+	//按上次丢包以来的报文数放大概率，丢包间隔更均匀
+	double pa = count * pb < 1 ? pb / (1 - count * pb) : 1;
+	if (rng.uniform() < pa) {
+		count = 0;
+		return true;
+	}
+	return false;
+}
+
+double BottleneckQueue::admit(double now, SimRandom &rng)
+{
+	int len = length(now);
+	arrivals++;
+	lengthSum += len;
+	if (config.policy == QUEUE_RED && dropEarly(len, now, rng)) {
+		earlyDrops++;
+		return -1;
+	}
+	if (len >= config.queueLimit) {
+		tailDrops++;
+		return -1;
+	}
+	double begin = linkFree > now ? linkFree : now;
+	delaySum += begin - now;
+	linkFree = begin + config.transmissionTime;
+	departures.push_back(linkFree);
+	if (len + 1 > maxLength) {
+		maxLength = len + 1;
+	}
+	return linkFree;
+}
+
+double BottleneckQueue::meanDelay() const
+{
+	long accepted = arrivals - tailDrops - earlyDrops;
+	return accepted > 0 ? delaySum / accepted : 0;
+}
@@ -0,0 +1,117 @@
+#include "../include/Channel.h"
+
+static const int BAD_FIELD = 0xfff0bdc1; //损坏报文头部时写入的值，与libnetsim相同
+
+void ChannelConfig::setBurstLoss(double loss, double burst)
+{
+	if (burst <= 1 || loss <= 0 || loss >= 1) {
+		lossModel = LOSS_BERNOULLI;
+		lossRate = loss;
+		return;
+	}
+	//坏状态必丢、好状态不丢时，稳态丢包率 = goodToBad / (goodToBad + badToGood)
+	lossModel = LOSS_GILBERT_ELLIOTT;
+	lossGood = 0;
+	lossBad = 1;
+	badToGood = 1 / burst;
+	goodToBad = loss * badToGood / (1 - loss);
+}
+
+double ChannelConfig::averageLoss() const
+{
+	if (lossModel == LOSS_BERNOULLI) {
+		return lossRate;
+	}
+	double sum = goodToBad + badToGood;
+	if (sum <= 0) {
+		return lossGood;
+	}
+	double pBad = goodToBad / sum;
+	return (1 - pBad) * lossGood + pBad * lossBad;
+}
+
+Channel::Channel()
+{
+	configure(ChannelConfig());
+}
+
+void Channel::configure(const ChannelConfig &c)
+{
+	config = c;
+	bad = false;
+	linkFree = 0;
+	lastArrival = 0;
+}
+
+bool Channel::lose(SimRandom &rng)
+{
+	if (config.lossModel == LOSS_BERNOULLI) {
+		return config.lossRate > 0 && rng.uniform() < config.lossRate;
+	}
+	double p = bad ? config.lossBad : config.lossGood;
+	bool lost = p > 0 && rng.uniform() < p;
+	//先按当前状态决定这个报文，再转移到下一个报文的状态
+	if (bad) {
+		bad = !(rng.uniform() < config.badToGood);
+	} else {
+		bad = rng.uniform() < config.goodToBad;
+	}
+	return lost;
+}
+
+void Channel::corrupt(Packet &pkt, SimRandom &rng)
+{
+	//与libnetsim相同：3/4的概率改动payload，其余改动序号或确认号
+	double r = rng.uniform();
+	if (r < 0.75) {
+		pkt.payload[0]++;
+	} else if (r < 0.875) {
+		pkt.seqnum = BAD_FIELD;
+	} else {
+		pkt.acknum = BAD_FIELD;
+	}
+}
+
+double Channel::delay(double departure, SimRandom &rng, bool &reordered)
+{
+	double arrival = departure + config.minDelay;
+	if (config.jitter > 0) {
+		arrival += config.jitter * rng.uniform();
+	}
+	if (config.reorderRate > 0 && rng.uniform() < config.reorderRate) {
+		//被额外延迟的报文不参与保序，也不推迟后面的报文
+		reordered = true;
+		return arrival + config.reorderDelay;
+	}
+	if (arrival < lastArrival) {
+		arrival = lastArrival;
+	}
+	lastArrival = arrival;
+	return arrival;
+}
+
+Transmission Channel::transmit(double now, Packet &pkt, SimRandom &rng)
+{
+	Transmission t;
+	t.lost = false;
+	t.corrupted = false;
+	t.reordered = false;
+	t.copies = 0;
+
+	double begin = linkFree > now ? linkFree : now;
+	linkFree = begin + config.transmissionTime;
+
+	if (lose(rng)) {
+		t.lost = true;
+		return t;
+	}
+	if (config.corruptRate > 0 && rng.uniform() < config.corruptRate) {
+		corrupt(pkt, rng);
+		t.corrupted = true;
+	}
+	t.arrival[t.copies++] = delay(linkFree, rng, t.reordered);
+	if (config.duplicateRate > 0 && rng.uniform() < config.duplicateRate) {
+		t.arrival[t.copies++] = delay(linkFree, rng, t.reordered);
+	}
+	return t;
+}
@@ -0,0 +1,77 @@
+#include "../include/DataStructure.h"
+#include <iostream>
+#include <string.h>
+using namespace std;
+
+Message::Message()
+{
+}
+
+Message::Message(const Message &msg)
+{
+	memcpy(data, msg.data, sizeof(data));
+}
+
+Message &Message::operator=(const Message &msg)
+{
+	memcpy(data, msg.data, sizeof(data));
+	return *this;
+}
+
+Message::~Message()
+{
+}
+
+void Message::print()
+{
+	for (int i = 0; i < Configuration::PAYLOAD_SIZE; i++) {
+		if (data[i] != '\n') {
+			cout << data[i];
+		}
+	}
+	cout << endl;
+}
+
+Packet::Packet()
+{
+}
+
+Packet::Packet(const Packet &pkt)
+	: seqnum(pkt.seqnum)
+	, acknum(pkt.acknum)
+	, checksum(pkt.checksum)
+{
+	memcpy(payload, pkt.payload, sizeof(payload));
+}
+
+Packet &Packet::operator=(const Packet &pkt)
+{
+	seqnum = pkt.seqnum;
+	acknum = pkt.acknum;
+	checksum = pkt.checksum;
+	memcpy(payload, pkt.payload, sizeof(payload));
+	return *this;
+}
+
+bool Packet::operator==(const Packet &pkt) const
+{
+	return seqnum == pkt.seqnum && acknum == pkt.acknum &&
+	       checksum == pkt.checksum &&
+	       memcmp(payload, pkt.payload, sizeof(payload)) == 0;
+}
+
+Packet::~Packet()
+{
+}
+
+void Packet::print()
+{
+	cout << "seqnum = " << seqnum << ", acknum = " << acknum
+	     << ",checksum = " << checksum << ",payload = ";
+	for (int i = 0; i < Configuration::PAYLOAD_SIZE; i++) {
+		if (payload[i] != '\n') {
+			cout << payload[i];
+		}
+	}
+	cout << endl;
+}
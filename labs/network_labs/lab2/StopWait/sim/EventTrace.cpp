@@ -0,0 +1,52 @@
+#include "../include/EventTrace.h"
+
+TraceWriter::TraceWriter(size_t capacity)
+	: file(nullptr)
+	, buffer(capacity > 0 ? capacity : 1)
+	, used(0)
+	, records(0)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+	close();
+}
+
+bool TraceWriter::open(const char *path)
+{
+	close();
+	file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	TraceFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "RDTTRACE", sizeof(header.magic));
+	header.version = VERSION;
+	header.recordSize = sizeof(TraceRecord);
+	header.payloadSize = Configuration::PAYLOAD_SIZE;
+	fwrite(&header, sizeof(header), 1, file);
+	used = 0;
+	records = 0;
+	return true;
+}
+
+void TraceWriter::flush()
+{
+	//没有打开文件时缓冲区循环使用，只保留计数
+	if (file && used > 0) {
+		fwrite(buffer.data(), sizeof(TraceRecord), used, file);
+	}
+	used = 0;
+}
+
+void TraceWriter::close()
+{
+	if (!file) {
+		return;
+	}
+	flush();
+	fclose(file);
+	file = nullptr;
+}
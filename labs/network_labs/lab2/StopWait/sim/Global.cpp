@@ -0,0 +1,29 @@
+#include "../include/NetworkSimulator.h"
+#include "../include/SimTool.h"
+
+// 每个线程第一次用到时创建自己的实例。主线程的由main在结束前delete并置空，
+// 其他线程的在线程结束时由ThreadInstances释放（包括包装在外面的ChecksumTool、FecNetwork）
+// 程序自己定义了pUtils和pns时（比如基准测试），链接器不会从静态库中取出这个文件
+namespace {
+struct ThreadInstances {
+	~ThreadInstances()
+	{
+		delete pUtils;
+		delete pns;
+		pUtils = nullptr;
+		pns = nullptr;
+	}
+};
+
+thread_local ThreadInstances instances;
+
+template <typename T>
+T *create()
+{
+	(void)&instances; //第一次取地址时构造，线程结束时析构
+	return new T();
+}
+}
+
+NETSIM_GLOBAL Tool *pUtils = create<SimTool>();
+NETSIM_GLOBAL NetworkService *pns = create<NetworkSimulator>();
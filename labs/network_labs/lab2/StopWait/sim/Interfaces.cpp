@@ -0,0 +1,18 @@
+#include "../include/Global.h"
+
+// 抽象类的纯虚析构函数也必须有定义，派生类析构时会调用
+RdtSender::~RdtSender()
+{
+}
+
+RdtReceiver::~RdtReceiver()
+{
+}
+
+Tool::~Tool()
+{
+}
+
+NetworkService::~NetworkService()
+{
+}
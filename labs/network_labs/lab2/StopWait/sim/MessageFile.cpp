@@ -0,0 +1,77 @@
+#include "../include/NetworkSimulator.h"
+#include <stdio.h>
+
+// 按PAYLOAD_SIZE字节一块读取输入文件，最后不足一块的部分用0补齐
+class FileMessageSource : public MessageSource {
+private:
+	FILE *fp;
+	Message ahead;
+	bool more;
+
+	void fetch()
+	{
+		memset(ahead.data, 0, sizeof(ahead.data));
+		more = fread(ahead.data, 1, sizeof(ahead.data), fp) > 0;
+	}
+public:
+	explicit FileMessageSource(FILE *f)
+		: fp(f)
+	{
+		setvbuf(fp, nullptr, _IOFBF, 1 << 16);
+		fetch();
+	}
+
+	~FileMessageSource()
+	{
+		fclose(fp);
+	}
+
+	bool hasMore()
+	{
+		return more;
+	}
+
+	void next(Message &msg)
+	{
+		msg = ahead;
+		fetch();
+	}
+};
+
+// 与libnetsim相同，写出时跳过补齐用的0字节，输出文件与输入文件逐字节相同
+class FileMessageSink : public MessageSink {
+private:
+	FILE *fp;
+public:
+	explicit FileMessageSink(FILE *f)
+		: fp(f)
+	{
+		setvbuf(fp, nullptr, _IOFBF, 1 << 16);
+	}
+
+	~FileMessageSink()
+	{
+		fclose(fp);
+	}
+
+	void write(const Message &msg)
+	{
+		for (int i = 0; i < Configuration::PAYLOAD_SIZE; i++) {
+			if (msg.data[i] != '\0') {
+				putc(msg.data[i], fp);
+			}
+		}
+	}
+};
+
+MessageSource *openFileSource(const char *path)
+{
+	FILE *fp = fopen(path, "rb");
+	return fp ? new FileMessageSource(fp) : nullptr;
+}
+
+MessageSink *openFileSink(const char *path)
+{
+	FILE *fp = fopen(path, "wb");
+	return fp ? new FileMessageSink(fp) : nullptr;
+}
@@ -0,0 +1,325 @@
+#include "../include/MultiFlowSimulator.h"
+#include <stdio.h>
+#include <time.h>
+
+/* ---------------- FlowPort ---------------- */
+
+void MultiFlowSimulator::FlowPort::startTimer(RandomEventTarget target,
+					      int timeOut, int seqNum)
+{
+	sim.startTimer(flow, target, timeOut, seqNum);
+}
+
+void MultiFlowSimulator::FlowPort::stopTimer(RandomEventTarget target, int seqNum)
+{
+	sim.stopTimer(flow, target, seqNum);
+}
+
+void MultiFlowSimulator::FlowPort::sendToNetworkLayer(RandomEventTarget target,
+						      Packet pkt)
+{
+	sim.send(flow, target, pkt);
+}
+
+void MultiFlowSimulator::FlowPort::delivertoAppLayer(RandomEventTarget, Message msg)
+{
+	sim.deliver(flow, msg);
+}
+
+/* ---------------- MultiFlowSimulator ---------------- */
+
+// 调用某个流的协议期间pns指向这个流的FlowPort
+struct CurrentFlow {
+	NetworkService *saved;
+	explicit CurrentFlow(NetworkService *port)
+		: saved(pns)
+	{
+		pns = port;
+	}
+	~CurrentFlow()
+	{
+		pns = saved;
+	}
+};
+
+MultiFlowSimulator::MultiFlowSimulator()
+	: runMode(1)
+	, duration(0)
+	, rng((uint64_t)time(nullptr))
+	, currentTime(0)
+{
+	events.reserve(1024);
+}
+
+MultiFlowSimulator::~MultiFlowSimulator()
+{
+	for (Flow *f : flows) {
+		delete f->port;
+		delete f;
+	}
+}
+
+int MultiFlowSimulator::addFlow(const char *name, RdtSender *sender,
+				RdtReceiver *receiver, MessageSource *source,
+				MessageSink *sink, const FlowConfig &config)
+{
+	int id = (int)flows.size();
+	Flow *f = new Flow();
+	f->name = name;
+	f->sender = sender;
+	f->receiver = receiver;
+	f->source = source;
+	f->sink = sink;
+	f->config = config;
+	f->port = new FlowPort(*this, id);
+	f->data.configure(config.data);
+	f->ack.configure(config.ack);
+	f->started = false;
+	flows.push_back(f);
+	return id;
+}
+
+void MultiFlowSimulator::startTimer(int flow, RandomEventTarget target,
+				    int timeOut, int seqNum)
+{
+	uint64_t key = timerKey(flow, target, seqNum);
+	if (timers.count(key)) {
+		return; //与NetworkSimulator相同，已经存在的定时器不重新启动
+	}
+	Event e;
+	e.time = currentTime + timeOut;
+	e.kind = TIMEOUT;
+	e.flow = flow;
+	e.target = target;
+	e.seqNum = seqNum;
+	e.slot = -1;
+	timers[key] = events.push(e);
+}
+
+void MultiFlowSimulator::stopTimer(int flow, RandomEventTarget target, int seqNum)
+{
+	timers.erase(timerKey(flow, target, seqNum));
+}
+
+void MultiFlowSimulator::schedulePacket(int flow, RandomEventTarget target,
+					const Packet &pkt, double arrival)
+{
+	int slot;
+	if (freeSlots.empty()) {
+		slot = (int)packets.size();
+		packets.push_back(pkt);
+	} else {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		packets[slot] = pkt;
+	}
+	Event e;
+	e.time = arrival;
+	e.kind = PACKET_ARRIVAL;
+	e.flow = flow;
+	e.target = target;
+	e.seqNum = 0;
+	e.slot = slot;
+	events.push(e);
+}
+
+void MultiFlowSimulator::send(int flow, RandomEventTarget target, Packet &pkt)
+{
+	Flow &f = *flows[flow];
+	Transmission t;
+	if (target == RECEIVER) {
+		f.stats.dataPackets++;
+		f.detail.onData();
+		//先排队通过瓶颈链路，离开后再经过这个流自己的路径
+		double departure = bottleneck.admit(currentTime, rng);
+		if (departure < 0) {
+			f.stats.queueDrops++;
+			return;
+		}
+		t = f.data.transmit(departure, pkt, rng);
+	} else {
+		f.stats.ackPackets++;
+		f.detail.onAck();
+		t = f.ack.transmit(currentTime, pkt, rng);
+	}
+	if (t.lost) {
+		f.stats.pathLost++;
+		return;
+	}
+	for (int i = 0; i < t.copies; i++) {
+		schedulePacket(flow, target, pkt, t.arrival[i]);
+	}
+}
+
+void MultiFlowSimulator::deliver(int flow, const Message &msg)
+{
+	Flow &f = *flows[flow];
+	f.stats.delivered++;
+	f.stats.lastDelivery = currentTime;
+	f.detail.onDeliver(currentTime);
+	if (f.sink) {
+		f.sink->write(msg);
+	}
+}
+
+void MultiFlowSimulator::feed(Flow &f)
+{
+	long n = f.feeder.feed(f.sender);
+	f.stats.messages += n;
+	f.detail.onSubmit(currentTime, n);
+}
+
+bool MultiFlowSimulator::cancelled(const Event &e) const
+{
+	if (e.kind != TIMEOUT) {
+		return false;
+	}
+	auto it = timers.find(timerKey(e.flow, e.target, e.seqNum));
+	return it == timers.end() || it->second != e.order;
+}
+
+void MultiFlowSimulator::dispatch(const Event &e)
+{
+	Flow &f = *flows[e.flow];
+	CurrentFlow current(f.port);
+	switch (e.kind) {
+	case FLOW_START:
+		f.started = true;
+		break;
+	case PACKET_ARRIVAL: {
+		//先归还槽位再处理：receive中可能又发送报文
+		Packet pkt = packets[e.slot];
+		freeSlots.push_back(e.slot);
+		if (e.target == RECEIVER) {
+			f.receiver->receive(pkt);
+		} else {
+			f.sender->receive(pkt);
+		}
+		break;
+	}
+	case TIMEOUT: {
+		timers.erase(timerKey(e.flow, e.target, e.seqNum));
+		if (e.target == RECEIVER) {
+			f.receiver->timeoutHandler(e.seqNum);
+			break;
+		}
+		f.stats.timeouts++;
+		f.sender->timeoutHandler(e.seqNum);
+		break;
+	}
+	}
+	if (f.started) {
+		feed(f);
+		f.detail.onOccupancy(currentTime, f.sender->outstanding());
+	}
+}
+
+void MultiFlowSimulator::start()
+{
+	events.clear();
+	timers.clear();
+	packets.clear();
+	freeSlots.clear();
+	currentTime = 0;
+	bottleneck.configure(bottleneck.getConfig());
+	for (size_t i = 0; i < flows.size(); i++) {
+		Flow &f = *flows[i];
+		f.feeder.reset(f.source);
+		f.started = false;
+		f.stats = FlowStats();
+		f.detail.clear();
+		Event e;
+		e.time = f.config.startTime;
+		e.kind = FLOW_START;
+		e.flow = (int)i;
+		e.target = SENDER;
+		e.seqNum = 0;
+		e.slot = -1;
+		events.push(e);
+	}
+	while (!events.empty()) {
+		if (duration > 0 && events.top().time > duration) {
+			currentTime = duration;
+			break;
+		}
+		Event e = events.pop();
+		if (cancelled(e)) {
+			continue;
+		}
+		currentTime = e.time;
+		dispatch(e);
+	}
+	for (Flow *f : flows) {
+		f->detail.finish(currentTime);
+	}
+	if (runMode != 2) {
+		printStats();
+	}
+}
+
+double MultiFlowSimulator::goodput(int i) const
+{
+	const Flow &f = *flows[i];
+	double end = duration > 0 ? currentTime : f.stats.lastDelivery;
+	double span = end - f.config.startTime;
+	return span > 0 ? f.stats.delivered / span : 0;
+}
+
+double MultiFlowSimulator::aggregateGoodput() const
+{
+	double begin = 0, end = 0;
+	long delivered = 0;
+	for (size_t i = 0; i < flows.size(); i++) {
+		const Flow &f = *flows[i];
+		double last = duration > 0 ? currentTime : f.stats.lastDelivery;
+		if (i == 0 || f.config.startTime < begin) {
+			begin = f.config.startTime;
+		}
+		if (last > end) {
+			end = last;
+		}
+		delivered += f.stats.delivered;
+	}
+	return end > begin ? delivered / (end - begin) : 0;
+}
+
+double MultiFlowSimulator::jainIndex() const
+{
+	double sum = 0, squares = 0;
+	for (int i = 0; i < flowCount(); i++) {
+		double x = goodput(i);
+		sum += x;
+		squares += x * x;
+	}
+	return squares > 0 ? sum * sum / (flowCount() * squares) : 0;
+}
+
+void MultiFlowSimulator::printStats() const
+{
+	const BottleneckConfig &bc = bottleneck.getConfig();
+	printf("******多流模拟网络环境******：%d个流共用瓶颈链路，%s队列，容量%d个报文，带宽%g报文/时间单位，运行到%g\n",
+	       flowCount(), bc.policy == QUEUE_RED ? "RED" : "drop-tail",
+	       bc.queueLimit, bc.transmissionTime > 0 ? 1 / bc.transmissionTime : 0,
+	       currentTime);
+	printf("%-4s %-12s %10s %10s %10s %8s %8s %8s %10s %10s\n", "流", "协议",
+	       "递交", "goodput", "数据报文", "队列丢弃", "超时", "重传比例",
+	       "时延p50", "时延p99");
+	for (int i = 0; i < flowCount(); i++) {
+		const FlowStats &s = flows[i]->stats;
+		const StatsCollector &d = flows[i]->detail;
+		printf("%-4d %-12s %10ld %10.3f %10ld %8ld %8ld %7.2f%% %10.2f %10.2f\n",
+		       i, flowName(i), s.delivered, goodput(i), s.dataPackets,
+		       s.queueDrops, s.timeouts, 100 * d.retransmissionRatio(),
+		       d.getLatency().percentile(0.5), d.getLatency().percentile(0.99));
+	}
+	double capacity = bc.transmissionTime > 0 ? 1 / bc.transmissionTime : 0;
+	printf("总goodput: %.3f 消息/时间单位", aggregateGoodput());
+	if (capacity > 0) {
+		printf("（链路利用率 %.1f%%）", 100 * aggregateGoodput() / capacity);
+	}
+	printf(", Jain公平性指数: %.3f\n", jainIndex());
+	printf("瓶颈队列: 到达 %ld, 队满丢弃 %ld, 提前丢弃 %ld, 平均长度 %.1f, 最大长度 %d, 平均排队时延 %.3f\n\n",
+	       bottleneck.getArrivals(), bottleneck.getTailDrops(),
+	       bottleneck.getEarlyDrops(), bottleneck.meanLength(),
+	       bottleneck.getMaxLength(), bottleneck.meanDelay());
+}
@@ -0,0 +1,418 @@
+#include "../include/NetworkSimulator.h"
+#include <stdio.h>
+#include <time.h>
+
+#define SIM_PREFIX "******模拟网络环境******："
+
+static const int APP_ARRIVAL_BATCH = 5; //事件表为空时一次产生的应用层消息到达事件数，与libnetsim相同
+
+/* ---------------- NetworkSimulator ---------------- */
+
+NetworkSimulator::NetworkSimulator()
+	: rng((uint64_t)time(nullptr))
+	, runMode(0)
+	, sender(nullptr)
+	, receiver(nullptr)
+	, inputFile(nullptr)
+	, outputFile(nullptr)
+	, source(nullptr)
+	, sink(nullptr)
+	, trace(nullptr)
+	, collectRequested(false)
+	, collecting(false)
+	, currentTime(0)
+{
+	setConfig(SimConfig());
+	events.reserve(1024);
+}
+
+NetworkSimulator::~NetworkSimulator()
+{
+}
+
+void NetworkSimulator::setRtdSender(RdtSender *ps)
+{
+	sender = ps;
+}
+
+void NetworkSimulator::setRtdReceiver(RdtReceiver *pr)
+{
+	receiver = pr;
+}
+
+void NetworkSimulator::setInputFile(const char *ifile)
+{
+	inputFile = ifile;
+}
+
+void NetworkSimulator::setOutputFile(const char *ofile)
+{
+	outputFile = ofile;
+}
+
+void NetworkSimulator::setRunMode(int mode)
+{
+	runMode = mode;
+}
+
+void NetworkSimulator::startTimer(RandomEventTarget target, int timeOut,
+				  int seqNum)
+{
+	uint64_t key = timerKey(target, seqNum);
+	if (timers.count(key)) {
+		cout << SIM_PREFIX "试图启动一个已经存在的定时器" << endl;
+		return;
+	}
+	Event e;
+	e.time = currentTime + timeOut;
+	e.kind = TIMEOUT;
+	e.target = target;
+	e.seqNum = seqNum;
+	e.slot = -1;
+	timers[key] = events.push(e);
+	if (verbose()) {
+		cout << SIM_PREFIX "启动定时器, 当前时间 = " << currentTime
+		     << ", 定时器报文序号 = " << seqNum
+		     << ", 定时器Timeout时间 = " << e.time << endl;
+	}
+}
+
+void NetworkSimulator::stopTimer(RandomEventTarget target, int seqNum)
+{
+	if (verbose()) {
+		cout << SIM_PREFIX "关闭定时器, 当前时间 = " << currentTime
+		     << ", 定时器报文序号 = " << seqNum << endl;
+	}
+	timers.erase(timerKey(target, seqNum));
+}
+
+void NetworkSimulator::setConfig(const SimConfig &c)
+{
+	config = c;
+	channels[SENDER].configure(c.channel[SENDER]);
+	channels[RECEIVER].configure(c.channel[RECEIVER]);
+}
+
+void NetworkSimulator::schedulePacket(RandomEventTarget target,
+				      Packet &pkt, double arrival)
+{
+	int slot;
+	if (freeSlots.empty()) {
+		slot = (int)packets.size();
+		packets.push_back(pkt);
+	} else {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		packets[slot] = pkt;
+	}
+	Event e;
+	e.time = arrival;
+	e.kind = PACKET_ARRIVAL;
+	e.target = target;
+	e.seqNum = 0;
+	e.slot = slot;
+	events.push(e);
+
+	if (verbose()) {
+		cout << (target == RECEIVER ? SIM_PREFIX "发送方的数据包将在" :
+					      SIM_PREFIX "接收方的确认包将在")
+		     << arrival
+		     << (target == RECEIVER ? "到达对方, 数据包为-->" :
+					      "到达对方, 确认包为-->");
+		pkt.print();
+	}
+}
+
+void NetworkSimulator::sendToNetworkLayer(RandomEventTarget target, Packet pkt)
+{
+	bool data = target == RECEIVER;
+	(data ? stats.dataPackets : stats.ackPackets)++;
+	if (collecting) {
+		if (data) {
+			detail.onData();
+		} else {
+			detail.onAck();
+		}
+	}
+
+	//先记下发出的报文，transmit可能把pkt改成损坏后的内容
+	TraceRecord *sent = trace ? &trace->packet(currentTime, TRACE_SEND, target, pkt) : nullptr;
+	Transmission t = channels[target].transmit(currentTime, pkt, rng);
+	if (sent) {
+		sent->flags = (t.lost ? TRACE_LOST : 0) |
+			      (t.corrupted ? TRACE_CORRUPTED : 0) |
+			      (t.copies > 1 ? TRACE_DUPLICATED : 0) |
+			      (t.reordered ? TRACE_REORDERED : 0);
+	}
+	if (t.lost) {
+		(data ? stats.dataLost : stats.ackLost)++;
+		if (verbose()) {
+			cout << (data ? SIM_PREFIX "发送方发送的数据包丢失：" :
+					SIM_PREFIX "接收方发送的确认包丢失：");
+			pkt.print();
+		}
+		return;
+	}
+	if (t.corrupted) {
+		(data ? stats.dataCorrupted : stats.ackCorrupted)++;
+		if (verbose()) {
+			cout << SIM_PREFIX "网络层数据包损坏,损坏的包为-->";
+			pkt.print();
+		}
+	}
+	stats.duplicated += t.copies - 1;
+	if (t.reordered) {
+		stats.reordered++;
+	}
+	for (int i = 0; i < t.copies; i++) {
+		schedulePacket(target, pkt, t.arrival[i]);
+	}
+}
+
+void NetworkSimulator::delivertoAppLayer(RandomEventTarget, Message msg)
+{
+	if (verbose()) {
+		cout << SIM_PREFIX "向上递交给应用层数据：";
+		msg.print();
+	}
+	stats.delivered++;
+	stats.lastDelivery = currentTime;
+	if (collecting) {
+		detail.onDeliver(currentTime);
+	}
+	if (trace) {
+		trace->deliver(currentTime, msg);
+	}
+	if (sink) {
+		sink->write(msg);
+	}
+}
+
+void NetworkSimulator::init()
+{
+	if (runMode != 2) {
+		cout << SIM_PREFIX "模拟网络环境初始化..." << endl;
+	}
+}
+
+void NetworkSimulator::scheduleAppArrival()
+{
+	Event e;
+	e.time = currentTime +
+		 config.arrivalRate * rng.uniform() * APP_ARRIVAL_BATCH;
+	e.kind = APP_ARRIVAL;
+	e.target = SENDER;
+	e.seqNum = 0;
+	e.slot = -1;
+	events.push(e);
+}
+
+// 应用层总有数据可发：只要发送方不处于等待状态就继续交给它
+void NetworkSimulator::feed()
+{
+	long n = feeder.feed(sender);
+	stats.messages += n;
+	if (collecting) {
+		detail.onSubmit(currentTime, n);
+	}
+}
+
+// 与first同一时刻、紧接着到达发送方的确认包一起处理，窗口协议可以只移动一次窗口
+void NetworkSimulator::deliverAcks(const Event &first)
+{
+	static const size_t MAX_ACK_BATCH = 64;
+	ackBatch.clear();
+	ackBatch.push_back(packets[first.slot]);
+	if (trace) {
+		trace->packet(first.time, TRACE_ARRIVE, SENDER, ackBatch.back());
+	}
+	freeSlots.push_back(first.slot);
+	while (!events.empty() && ackBatch.size() < MAX_ACK_BATCH) {
+		const Event &next = events.top();
+		if (next.time != first.time || next.kind != PACKET_ARRIVAL ||
+		    next.target != SENDER) {
+			break;
+		}
+		Event e = events.pop();
+		ackBatch.push_back(packets[e.slot]);
+		if (trace) {
+			trace->packet(e.time, TRACE_ARRIVE, SENDER, ackBatch.back());
+		}
+		freeSlots.push_back(e.slot);
+		stats.events++;
+	}
+	sender->receiveBatch(Span<const Packet>(ackBatch.data(), ackBatch.size()));
+}
+
+bool NetworkSimulator::cancelled(const Event &e) const
+{
+	if (e.kind != TIMEOUT) {
+		return false;
+	}
+	auto it = timers.find(timerKey(e.target, e.seqNum));
+	return it == timers.end() || it->second != e.order;
+}
+
+void NetworkSimulator::dispatch(const Event &e)
+{
+	switch (e.kind) {
+	case APP_ARRIVAL:
+		if (source->hasMore() && !sender->getWaitingState()) {
+			Message msg;
+			source->next(msg);
+			stats.messages++;
+			if (sender->send(msg) && collecting) {
+				detail.onSubmit(currentTime);
+			}
+		}
+		break;
+	case PACKET_ARRIVAL: {
+		if (e.target == SENDER) {
+			deliverAcks(e);
+			break;
+		}
+		//先归还槽位再处理：receive中可能又发送报文
+		Packet pkt = packets[e.slot];
+		freeSlots.push_back(e.slot);
+		if (trace) {
+			trace->packet(e.time, TRACE_ARRIVE, RECEIVER, pkt);
+		}
+		receiver->receive(pkt);
+		break;
+	}
+	case TIMEOUT: {
+		timers.erase(timerKey(e.target, e.seqNum)); //run已经丢弃了取消的定时器
+		if (trace) {
+			trace->timeout(e.time, e.target, e.seqNum);
+		}
+		if (e.target == RECEIVER) {
+			receiver->timeoutHandler(e.seqNum); //接收方的延迟确认定时器，不计入超时重传
+			break;
+		}
+		stats.timeouts++;
+		sender->timeoutHandler(e.seqNum);
+		break;
+	}
+	}
+	stats.events++;
+}
+
+void NetworkSimulator::run()
+{
+	bool saturate = config.arrivalRate <= 0;
+	feeder.reset(source);
+	if (saturate) {
+		feed();
+	} else {
+		scheduleAppArrival();
+	}
+	for (;;) {
+		if (events.empty()) {
+			//与libnetsim相同：网络中没有待处理的事件时才产生下一批应用层消息
+			if (saturate || !source->hasMore()) {
+				break;
+			}
+			for (int i = 0; i < APP_ARRIVAL_BATCH; i++) {
+				scheduleAppArrival();
+			}
+			continue;
+		}
+		Event e = events.pop();
+		if (cancelled(e)) {
+			//不推进时钟：否则取消的定时器会把时间拖到它原来的到时时刻，堆中只剩它们时还会推迟下一批应用层消息
+			continue;
+		}
+		currentTime = e.time;
+		dispatch(e);
+		if (saturate) {
+			feed();
+		}
+		if (collecting) {
+			detail.onOccupancy(currentTime, sender->outstanding());
+		}
+	}
+	if (collecting) {
+		detail.finish(currentTime);
+	}
+}
+
+void NetworkSimulator::printStats()
+{
+	cout << SIM_PREFIX "模拟网络环境已发送完应用层数据，关闭模拟网络环境" << endl;
+	cout << "已发送应用层Message个数: " << stats.messages << endl;
+	cout << "发送到网络层数据Packet个数: " << stats.dataPackets << endl;
+	cout << "网络层丢失的数据Packet个数: " << stats.dataLost << endl;
+	cout << "网络层损坏的数据pakcet个数:" << stats.dataCorrupted << endl;
+	cout << "发送到网络层确认Packet个数:" << stats.ackPackets << endl;
+	cout << "网络层丢失的确认Packet个数: " << stats.ackLost << endl;
+	cout << "网络层损坏的确认Packet个数: " << stats.ackCorrupted << endl;
+	if (stats.duplicated || stats.reordered) {
+		cout << "网络层复制的Packet个数: " << stats.duplicated << endl;
+		cout << "网络层额外延迟的Packet个数: " << stats.reordered << endl;
+	}
+	if (collecting) {
+		cout.flush();
+		detail.print(stdout, Configuration::PAYLOAD_SIZE);
+		fflush(stdout);
+	}
+	cout << endl;
+}
+
+void NetworkSimulator::start()
+{
+	if (sender == nullptr) {
+		cout << SIM_PREFIX "没有设置发送方Rdt协议实体，模拟网络环境无法启动" << endl;
+		return;
+	}
+	if (receiver == nullptr) {
+		cout << SIM_PREFIX "没有设置接收方Rdt协议实体，模拟网络环境无法启动" << endl;
+		return;
+	}
+	if (source == nullptr && inputFile == nullptr) {
+		cout << SIM_PREFIX "没有设置发送文件路径，模拟网络环境无法启动" << endl;
+		return;
+	}
+	if (sink == nullptr && outputFile == nullptr) {
+		cout << SIM_PREFIX "没有设置接收文件路径，模拟网络环境无法启动" << endl;
+		return;
+	}
+
+	//没有指定消息来源和去向时使用输入、输出文件，仿真结束后关闭
+	MessageSource *ownSource = nullptr;
+	MessageSink *ownSink = nullptr;
+	if (source == nullptr) {
+		source = ownSource = openFileSource(inputFile);
+		if (source == nullptr) {
+			cout << "文件" << inputFile << "不存在. 模拟网络环境无法启动\n";
+			return;
+		}
+	}
+	if (sink == nullptr) {
+		sink = ownSink = openFileSink(outputFile);
+		if (sink == nullptr) {
+			cout << "文件" << outputFile << "无法创建. 模拟网络环境无法启动\n";
+			delete ownSource;
+			source = nullptr;
+			return;
+		}
+	}
+
+	if (runMode != 2) {
+		cout << SIM_PREFIX "模拟网络环境启动..." << endl;
+	}
+	collecting = runMode != 2 || collectRequested;
+	detail.clear();
+	run();
+	if (runMode != 2) {
+		printStats();
+	}
+
+	if (ownSource) {
+		delete ownSource;
+		source = nullptr;
+	}
+	if (ownSink) {
+		delete ownSink;
+		sink = nullptr;
+	}
+}
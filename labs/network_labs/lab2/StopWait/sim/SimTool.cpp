@@ -0,0 +1,45 @@
+#include "../include/SimTool.h"
+#include <stdio.h>
+#include <time.h>
+
+SimTool::SimTool()
+	: rng((uint64_t)time(nullptr) * 2654435761u)
+{
+}
+
+SimTool::~SimTool()
+{
+}
+
+void SimTool::printPacket(const char *description, const Packet &packet)
+{
+	printf("%s: ", description);
+	printf("seqnum = %d, acknum = %d, checksum = %d, ", packet.seqnum,
+	       packet.acknum, packet.checksum);
+	for (int i = 0; i < Configuration::PAYLOAD_SIZE - 1; i++) {
+		putchar(packet.payload[i]);
+	}
+	putchar('\n');
+}
+
+// 与libnetsim相同的16位反码和：先加seqnum和acknum，再把payload按高低字节两两相加
+// libnetsim在payload长度为奇数时会多读一个字节，这里把缺的低字节当作0
+// 在uint32_t中累加：libnetsim用int，seqnum与acknum相加可能溢出，负数右移还依赖符号扩展。
+// 两者之和为负或payload中有高位为1的字节时结果与libnetsim不同，收发双方用的是同一个pUtils，不影响校验
+int SimTool::calculateCheckSum(const Packet &packet)
+{
+	const unsigned char *payload = (const unsigned char *)packet.payload;
+	uint32_t sum = (uint32_t)packet.seqnum + (uint32_t)packet.acknum;
+	sum = (sum >> 16) + (sum & 0xffff);
+	for (int i = 0; i < Configuration::PAYLOAD_SIZE; i += 2) {
+		uint32_t low = i + 1 < Configuration::PAYLOAD_SIZE ? payload[i + 1] : 0;
+		sum += ((uint32_t)payload[i] << 8) + low;
+		sum = (sum >> 16) + (sum & 0xffff);
+	}
+	return (int)(~sum & 0xffff);
+}
+
+double SimTool::random()
+{
+	return rng.uniform();
+}
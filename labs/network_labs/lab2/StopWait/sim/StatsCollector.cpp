@@ -0,0 +1,239 @@
+#include "../include/StatsCollector.h"
+#include <string.h>
+
+/* ---------------- LatencyHistogram ---------------- */
+
+void LatencyHistogram::clear()
+{
+	memset(counts, 0, sizeof(counts));
+	total = 0;
+	sum = 0;
+	maxValue = 0;
+}
+
+int LatencyHistogram::bucketOf(double value)
+{
+	double scaled = value > 0 ? value * SCALE : 0;
+	uint64_t v = scaled < 4e18 ? (uint64_t)scaled : (uint64_t)4e18;
+	if (v < (uint64_t)SUB) {
+		return (int)v;
+	}
+	int e = 63 - __builtin_clzll(v);
+	int mant = (int)(v >> (e - SUB_BITS)) & (SUB - 1);
+	return (e - SUB_BITS + 1) * SUB + mant;
+}
+
+double LatencyHistogram::lowerBound(int bucket)
+{
+	if (bucket < SUB) {
+		return (double)bucket / SCALE;
+	}
+	int e = bucket / SUB + SUB_BITS - 1;
+	int mant = bucket % SUB;
+	return (double)((uint64_t)(SUB + mant) << (e - SUB_BITS)) / SCALE;
+}
+
+void LatencyHistogram::add(double value)
+{
+	counts[bucketOf(value)]++;
+	total++;
+	sum += value;
+	if (value > maxValue) {
+		maxValue = value;
+	}
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+	if (total == 0) {
+		return 0;
+	}
+	long rank = (long)(p * total);
+	if (rank >= total) {
+		rank = total - 1;
+	}
+	long seen = 0;
+	for (int b = 0; b < BUCKETS; b++) {
+		seen += counts[b];
+		if (seen > rank) {
+			double mid = (lowerBound(b) + lowerBound(b + 1)) / 2;
+			return mid < maxValue ? mid : maxValue;
+		}
+	}
+	return maxValue;
+}
+
+void LatencyHistogram::print(FILE *out) const
+{
+	static const int BAR = 40;
+	//第一行是[0, SUB/SCALE)，之后每行一个2的幂区间
+	for (int first = 0; first < BUCKETS; first += SUB) {
+		long n = 0;
+		for (int b = first; b < first + SUB; b++) {
+			n += counts[b];
+		}
+		if (n == 0) {
+			continue;
+		}
+		int hashes = (int)((double)n * BAR / total + 0.5);
+		fprintf(out, "  [%10.3f, %10.3f) %9ld %5.1f%% ", lowerBound(first),
+			lowerBound(first + SUB), n, 100.0 * n / total);
+		for (int i = 0; i < hashes; i++) {
+			fputc('#', out);
+		}
+		fputc('\n', out);
+	}
+}
+
+/* ---------------- StatsCollector ---------------- */
+
+void StatsCollector::clear()
+{
+	submitted = delivered = dataPackets = ackPackets = 0;
+	pending.clear();
+	unmatched = 0;
+	latency.clear();
+	firstSubmit = -1;
+	lastDelivery = 0;
+	hasOccupancy = false;
+	occupancy = 0;
+	maxOccupancy = 0;
+	lastTime = 0;
+	period = 1;
+	series.clear();
+	integral = 0;
+}
+
+void StatsCollector::onSubmit(double t, long n)
+{
+	if (n <= 0) {
+		return;
+	}
+	if (firstSubmit < 0) {
+		firstSubmit = t;
+	}
+	submitted += n;
+	for (long i = 0; i < n; i++) {
+		pending.push_back(t);
+	}
+}
+
+void StatsCollector::onDeliver(double t)
+{
+	delivered++;
+	lastDelivery = t;
+	if (pending.empty()) {
+		unmatched++;
+		return;
+	}
+	latency.add(t - pending.front());
+	pending.pop_front();
+}
+
+void StatsCollector::advance(double t)
+{
+	while (lastTime < t) {
+		size_t index = (size_t)(lastTime / period);
+		if (index >= (size_t)SERIES) {
+			//相邻两段合并，每段时长加倍
+			for (int i = 0; i < SERIES / 2; i++) {
+				series[i] = series[2 * i] + series[2 * i + 1];
+			}
+			series.resize(SERIES / 2);
+			period *= 2;
+			continue;
+		}
+		if (series.size() <= index) {
+			series.resize(index + 1, 0);
+		}
+		double end = (index + 1) * period;
+		if (end > t) {
+			end = t;
+		}
+		double area = occupancy * (end - lastTime);
+		series[index] += area;
+		integral += area;
+		lastTime = end;
+	}
+}
+
+void StatsCollector::onOccupancy(double t, int outstanding)
+{
+	if (outstanding < 0) {
+		return;
+	}
+	hasOccupancy = true;
+	advance(t);
+	occupancy = outstanding;
+	if (outstanding > maxOccupancy) {
+		maxOccupancy = outstanding;
+	}
+}
+
+void StatsCollector::finish(double t)
+{
+	if (hasOccupancy) {
+		advance(t);
+	}
+}
+
+double StatsCollector::goodput() const
+{
+	double span = lastDelivery - (firstSubmit > 0 ? firstSubmit : 0);
+	return span > 0 ? delivered / span : 0;
+}
+
+double StatsCollector::retransmissionRatio() const
+{
+	return dataPackets > submitted ? (double)(dataPackets - submitted) / dataPackets : 0;
+}
+
+double StatsCollector::messagesPerAck() const
+{
+	return ackPackets ? (double)delivered / ackPackets : 0;
+}
+
+double StatsCollector::meanOccupancy() const
+{
+	return lastTime > 0 ? integral / lastTime : 0;
+}
+
+void StatsCollector::print(FILE *out, int payloadSize) const
+{
+	double g = goodput();
+	fprintf(out, "有效吞吐量: %.4f 消息/时间单位, %.2f 字节/时间单位\n", g,
+		g * payloadSize);
+	fprintf(out, "重传比例: %.2f%% (数据报文 %ld, 其中首次发送 %ld)\n",
+		100 * retransmissionRatio(), dataPackets, submitted);
+	fprintf(out, "确认效率: 每个确认报文对应 %.3f 个递交的消息 (确认报文 %ld)\n",
+		messagesPerAck(), ackPackets);
+	if (latency.count() > 0) {
+		fprintf(out, "消息时延(时间单位): 平均 %.3f, p50 %.3f, p90 %.3f, p99 %.3f, 最大 %.3f\n",
+			latency.mean(), latency.percentile(0.5),
+			latency.percentile(0.9), latency.percentile(0.99),
+			latency.max());
+		latency.print(out);
+	}
+	if (unmatched > 0) {
+		fprintf(out, "多递交的消息: %ld\n", unmatched);
+	}
+	if (hasOccupancy && lastTime > 0) {
+		fprintf(out, "发送窗口占用: 平均 %.2f, 最大 %d\n", meanOccupancy(),
+			maxOccupancy);
+		//最多打印PRINTED段，每段由相邻的group段合并
+		static const size_t PRINTED = 16;
+		size_t group = (series.size() + PRINTED - 1) / PRINTED;
+		double span = period * group;
+		fprintf(out, "  每%g个时间单位的平均值:", span);
+		for (size_t i = 0; i < series.size(); i += group) {
+			double area = 0;
+			for (size_t j = i; j < i + group && j < series.size(); j++) {
+				area += series[j];
+			}
+			double begin = i * period;
+			double len = lastTime - begin < span ? lastTime - begin : span;
+			fprintf(out, " %.1f", len > 0 ? area / len : 0);
+		}
+		fputc('\n', out);
+	}
+}
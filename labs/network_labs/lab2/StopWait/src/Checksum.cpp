@@ -0,0 +1,277 @@
+#include "../include/Checksum.h"
+#include <immintrin.h>
+
+// Packet带虚函数表，不能用offsetof，按一个实例算出各字段的偏移
+struct PacketLayout {
+	int header; //seqnum，紧接着是acknum
+	int payload;
+
+	PacketLayout()
+	{
+		Packet p;
+		const char *base = (const char *)&p;
+		header = (int)((const char *)&p.seqnum - base);
+		payload = (int)((const char *)p.payload - base);
+	}
+};
+
+static const PacketLayout layout;
+static bool simd = true;
+
+static inline const unsigned char *headerOf(const Packet &pkt)
+{
+	return (const unsigned char *)&pkt.seqnum;
+}
+
+bool checksumSimdAvailable()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_cpu_supports("avx2") &&
+	       __builtin_cpu_supports("sse4.2");
+#else
+	return false;
+#endif
+}
+
+void setChecksumSimd(bool enable)
+{
+	simd = enable;
+}
+
+/* ---------------- Internet校验和 ---------------- */
+
+static inline uint32_t sum16(const unsigned char *p, int len, uint32_t sum)
+{
+	for (; len >= 2; p += 2, len -= 2) {
+		uint16_t w;
+		memcpy(&w, p, 2);
+		sum += w;
+	}
+	if (len) {
+		sum += *p; //奇数长度时最后一个字节作为低字节，高字节补0
+	}
+	return sum;
+}
+
+static inline uint16_t fold(uint32_t sum)
+{
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t)~sum;
+}
+
+uint16_t internetChecksum(const Packet &pkt)
+{
+	//seqnum和acknum是相邻的两个int
+	uint32_t sum = sum16(headerOf(pkt), 2 * sizeof(int), 0);
+	sum = sum16((const unsigned char *)pkt.payload,
+		    Configuration::PAYLOAD_SIZE, sum);
+	return fold(sum);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 这个内核按21字节的payload展开，其他payload大小时不使用
+static const bool kernelFits = Configuration::PAYLOAD_SIZE == 21;
+
+// 每个lane对应一个报文：按报文间距gather同一位置的32位数据，拆成两个16位字累加
+__attribute__((target("avx2"))) static void
+internetChecksum8(const Packet *pkts, int *out)
+{
+	const char *base = (const char *)pkts;
+	const int stride = (int)sizeof(Packet);
+	const __m256i index = _mm256_setr_epi32(0, stride, 2 * stride,
+						3 * stride, 4 * stride,
+						5 * stride, 6 * stride,
+						7 * stride);
+	const __m256i low = _mm256_set1_epi32(0xffff);
+	const int offsets[] = { layout.header, layout.header + 4,
+				layout.payload, layout.payload + 4,
+				layout.payload + 8, layout.payload + 12,
+				layout.payload + 16 };
+
+	__m256i sum = _mm256_setzero_si256();
+	for (int off : offsets) {
+		__m256i v = _mm256_i32gather_epi32((const int *)(base + off),
+						   index, 1);
+		sum = _mm256_add_epi32(sum, _mm256_and_si256(v, low));
+		sum = _mm256_add_epi32(sum, _mm256_srli_epi32(v, 16));
+	}
+	//payload的第21个字节：读payload[17..20]再右移24位，不会越过报文末尾
+	__m256i last = _mm256_i32gather_epi32(
+		(const int *)(base + layout.payload + 17), index, 1);
+	sum = _mm256_add_epi32(sum, _mm256_srli_epi32(last, 24));
+
+	sum = _mm256_add_epi32(_mm256_and_si256(sum, low),
+			       _mm256_srli_epi32(sum, 16));
+	sum = _mm256_add_epi32(_mm256_and_si256(sum, low),
+			       _mm256_srli_epi32(sum, 16));
+	sum = _mm256_andnot_si256(sum, low);
+	_mm256_storeu_si256((__m256i *)out, sum);
+}
+#endif
+
+void internetChecksumBatch(const Packet *pkts, int n, int *out)
+{
+	int i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool avx2 = checksumSimdAvailable();
+	if (simd && avx2 && kernelFits) {
+		for (; i + 8 <= n; i += 8) {
+			internetChecksum8(pkts + i, out + i);
+		}
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = internetChecksum(pkts[i]);
+	}
+}
+
+/* ---------------- CRC32C ---------------- */
+
+struct Crc32cTable {
+	uint32_t t[256];
+
+	Crc32cTable()
+	{
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c >> 1) ^ (0x82f63b78 & (0 - (c & 1)));
+			}
+			t[i] = c;
+		}
+	}
+};
+
+static const Crc32cTable crcTable;
+
+static inline uint32_t crcBytes(uint32_t crc, const unsigned char *p, int len)
+{
+	while (len--) {
+		crc = crcTable.t[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static uint32_t crc32cScalar(const Packet &pkt)
+{
+	uint32_t crc = 0xffffffff;
+	crc = crcBytes(crc, headerOf(pkt), 2 * sizeof(int));
+	crc = crcBytes(crc, (const unsigned char *)pkt.payload,
+		       Configuration::PAYLOAD_SIZE);
+	return ~crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) static inline uint32_t
+crcHw(uint32_t crc, const unsigned char *p, int len)
+{
+	for (; len >= 8; p += 8, len -= 8) {
+		uint64_t v;
+		memcpy(&v, p, 8);
+		crc = (uint32_t)_mm_crc32_u64(crc, v);
+	}
+	if (len >= 4) {
+		uint32_t v;
+		memcpy(&v, p, 4);
+		crc = _mm_crc32_u32(crc, v);
+		p += 4;
+		len -= 4;
+	}
+	for (int k = 0; k < len; k++) {
+		crc = _mm_crc32_u8(crc, p[k]);
+	}
+	return crc;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t
+crc32cHw(const Packet &pkt)
+{
+	uint32_t crc = crcHw(0xffffffff, headerOf(pkt), 2 * sizeof(int));
+	crc = crcHw(crc, (const unsigned char *)pkt.payload,
+		    Configuration::PAYLOAD_SIZE);
+	return ~crc;
+}
+#endif
+
+uint32_t crc32c(const Packet &pkt)
+{
+#if defined(__x86_64__)
+	static const bool sse42 = __builtin_cpu_supports("sse4.2");
+	if (simd && sse42) {
+		return crc32cHw(pkt);
+	}
+#endif
+	return crc32cScalar(pkt);
+}
+
+void crc32cBatch(const Packet *pkts, int n, int *out)
+{
+	//各报文的crc32指令链互不依赖，乱序执行已经能把它们重叠起来，手工交错反而更慢
+	for (int i = 0; i < n; i++) {
+		out[i] = (int)crc32c(pkts[i]);
+	}
+}
+
+/* ---------------- ChecksumTool ---------------- */
+
+ChecksumTool::ChecksumTool(Tool *tool, ChecksumKind k)
+	: inner(tool)
+	, kind(k)
+{
+}
+
+ChecksumTool::~ChecksumTool()
+{
+	delete inner;
+}
+
+void ChecksumTool::printPacket(const char *description, const Packet &packet)
+{
+	inner->printPacket(description, packet);
+}
+
+int ChecksumTool::calculateCheckSum(const Packet &packet)
+{
+	switch (kind) {
+	case CHECKSUM_INTERNET:
+		return internetChecksum(packet);
+	case CHECKSUM_CRC32C:
+		return (int)crc32c(packet);
+	default:
+		return inner->calculateCheckSum(packet);
+	}
+}
+
+void ChecksumTool::calculateCheckSumBatch(const Packet *pkts, int n, int *out)
+{
+	switch (kind) {
+	case CHECKSUM_INTERNET:
+		internetChecksumBatch(pkts, n, out);
+		break;
+	case CHECKSUM_CRC32C:
+		crc32cBatch(pkts, n, out);
+		break;
+	default:
+		for (int i = 0; i < n; i++) {
+			out[i] = inner->calculateCheckSum(pkts[i]);
+		}
+	}
+}
+
+void checksumBatch(const Packet *pkts, int n, int *out)
+{
+	ChecksumTool *tool = dynamic_cast<ChecksumTool *>(pUtils);
+	if (tool) {
+		tool->calculateCheckSumBatch(pkts, n, out);
+		return;
+	}
+	for (int i = 0; i < n; i++) {
+		out[i] = pUtils->calculateCheckSum(pkts[i]);
+	}
+}
+
+double ChecksumTool::random()
+{
+	return inner->random();
+}
@@ -0,0 +1,508 @@
+#include "../include/Fec.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+//符号：数据报文中除acknum以外的全部内容
+static const int SYMBOL_SIZE = 2 * sizeof(int) + Configuration::PAYLOAD_SIZE;
+
+//acknum中的标记：最高位为1表示经过FEC编码，次高位区分校验报文和数据报文，中间22位是块号，低8位是块内位置
+//数据报文的acknum本来是-1，信道损坏acknum时写入的值次高位为1、位置超出r，都不会被当作合法的标记
+static const uint32_t TAG_FEC = 0x80000000u;
+static const uint32_t TAG_PARITY = 0x40000000u;
+static const uint32_t BLOCK_BITS = 22;
+static const uint32_t BLOCK_MASK = (1u << BLOCK_BITS) - 1;
+
+static int makeTag(bool isParity, uint32_t block, int pos)
+{
+	return (int)(TAG_FEC | (isParity ? TAG_PARITY : 0) |
+		     ((block & BLOCK_MASK) << 8) | (uint32_t)pos);
+}
+
+/* ---------------- GF(2^8) ---------------- */
+
+struct GaloisField {
+	uint8_t exp[512];
+	uint8_t log[256];
+
+	GaloisField()
+	{
+		//本原多项式x^8 + x^4 + x^3 + x^2 + 1
+		int x = 1;
+		for (int i = 0; i < 255; i++) {
+			exp[i] = (uint8_t)x;
+			log[x] = (uint8_t)i;
+			x <<= 1;
+			if (x & 0x100) {
+				x ^= 0x11d;
+			}
+		}
+		for (int i = 255; i < 512; i++) {
+			exp[i] = exp[i - 255];
+		}
+		log[0] = 0;
+	}
+
+	uint8_t mul(uint8_t a, uint8_t b) const
+	{
+		return a && b ? exp[log[a] + log[b]] : 0;
+	}
+
+	uint8_t inv(uint8_t a) const
+	{
+		return exp[255 - log[a]];
+	}
+
+	// dst += c * src，GF(2^8)中加法就是异或
+	void mulAdd(uint8_t *dst, const uint8_t *src, uint8_t c, int len) const
+	{
+		if (c == 0) {
+			return;
+		}
+		if (c == 1) {
+			for (int i = 0; i < len; i++) {
+				dst[i] ^= src[i];
+			}
+			return;
+		}
+		int lc = log[c];
+		for (int i = 0; i < len; i++) {
+			if (src[i]) {
+				dst[i] ^= exp[log[src[i]] + lc];
+			}
+		}
+	}
+};
+
+static const GaloisField gf;
+
+//第j个校验符号中第i个数据符号的系数：异或码全为1；RS码取Cauchy矩阵1/(x_j + y_i)，x_j = j，y_i = r + i，
+//Cauchy矩阵的任意方阵子式都可逆，所以任意r个丢失都能解出来
+static uint8_t coefficient(const FecConfig &c, int j, int i)
+{
+	if (c.code == FEC_XOR) {
+		return 1;
+	}
+	return gf.inv((uint8_t)(j ^ (c.r + i)));
+}
+
+static void toSymbol(const Packet &pkt, uint8_t *sym)
+{
+	memcpy(sym, &pkt.seqnum, sizeof(int));
+	memcpy(sym + sizeof(int), &pkt.checksum, sizeof(int));
+	memcpy(sym + 2 * sizeof(int), pkt.payload, Configuration::PAYLOAD_SIZE);
+}
+
+static void fromSymbol(const uint8_t *sym, Packet &pkt)
+{
+	memcpy(&pkt.seqnum, sym, sizeof(int));
+	memcpy(&pkt.checksum, sym + sizeof(int), sizeof(int));
+	memcpy(pkt.payload, sym + 2 * sizeof(int), Configuration::PAYLOAD_SIZE);
+}
+
+// 在GF(2^8)上求m阶方阵的逆，a按行存放，原地替换为逆矩阵；奇异时返回false
+static bool invert(std::vector<uint8_t> &a, int m)
+{
+	std::vector<uint8_t> b(m * m, 0);
+	for (int i = 0; i < m; i++) {
+		b[i * m + i] = 1;
+	}
+	for (int col = 0; col < m; col++) {
+		int pivot = col;
+		while (pivot < m && a[pivot * m + col] == 0) {
+			pivot++;
+		}
+		if (pivot == m) {
+			return false;
+		}
+		if (pivot != col) {
+			for (int k = 0; k < m; k++) {
+				std::swap(a[pivot * m + k], a[col * m + k]);
+				std::swap(b[pivot * m + k], b[col * m + k]);
+			}
+		}
+		uint8_t scale = gf.inv(a[col * m + col]);
+		for (int k = 0; k < m; k++) {
+			a[col * m + k] = gf.mul(a[col * m + k], scale);
+			b[col * m + k] = gf.mul(b[col * m + k], scale);
+		}
+		for (int row = 0; row < m; row++) {
+			uint8_t f = a[row * m + col];
+			if (row == col || f == 0) {
+				continue;
+			}
+			for (int k = 0; k < m; k++) {
+				a[row * m + k] ^= gf.mul(f, a[col * m + k]);
+				b[row * m + k] ^= gf.mul(f, b[col * m + k]);
+			}
+		}
+	}
+	a.swap(b);
+	return true;
+}
+
+/* ---------------- FecConfig ---------------- */
+
+bool FecConfig::valid() const
+{
+	if (k < 1 || k > MAX_K || r < 1 || r > MAX_R || hold < 0) {
+		return false;
+	}
+	return code == FEC_RS || r == 1;
+}
+
+bool parseFec(const char *spec, FecConfig &config)
+{
+	int k = 0;
+	int r = 1;
+	if (strncasecmp(spec, "xor:", 4) == 0) {
+		if (sscanf(spec + 4, "%d", &k) != 1) {
+			return false;
+		}
+		config = FecConfig(FEC_XOR, k, 1);
+	} else if (strncasecmp(spec, "rs:", 3) == 0) {
+		if (sscanf(spec + 3, "%d:%d", &k, &r) != 2) {
+			return false;
+		}
+		config = FecConfig(FEC_RS, k, r);
+	} else {
+		return false;
+	}
+	return config.valid();
+}
+
+/* ---------------- FecDecoder ---------------- */
+
+FecDecoder::FecDecoder(FecNetwork &network)
+	: owner(network)
+	, upper(nullptr)
+	, blocks(BLOCK_SLOTS)
+	, holdTimer(false)
+{
+	const FecConfig &c = owner.config;
+	for (Block &b : blocks) {
+		b.used = false;
+		b.data.resize((size_t)c.k * SYMBOL_SIZE);
+		b.parity.resize((size_t)c.r * SYMBOL_SIZE);
+	}
+}
+
+FecDecoder::~FecDecoder()
+{
+}
+
+FecDecoder::Block *FecDecoder::blockFor(uint32_t id)
+{
+	Block &b = blocks[id % BLOCK_SLOTS];
+	if (b.used && b.id == id) {
+		return &b;
+	}
+	//块号在22位上回绕，比槽中的块新才占用这个槽，否则是早已淘汰的块
+	if (b.used && ((id - b.id) & BLOCK_MASK) >= (1u << (BLOCK_BITS - 1))) {
+		return nullptr;
+	}
+	if (b.used) {
+		deliver(b, true);
+	}
+	b.id = id;
+	b.used = true;
+	b.done = false;
+	b.dataMask = 0;
+	b.deliveredMask = 0;
+	b.parityMask = 0;
+	return &b;
+}
+
+void FecDecoder::deliver(Block &b, bool release)
+{
+	const FecConfig &c = owner.config;
+	Packet pkt;
+	for (int i = 0; i < c.k; i++) {
+		uint64_t bit = 1ull << i;
+		if (b.deliveredMask & bit) {
+			continue;
+		}
+		if (!(b.dataMask & bit)) {
+			if (release) {
+				continue;
+			}
+			break;
+		}
+		fromSymbol(&b.data[(size_t)i * SYMBOL_SIZE], pkt);
+		pkt.acknum = -1;
+		b.deliveredMask |= bit;
+		upper->receive(pkt);
+	}
+}
+
+void FecDecoder::releaseBefore(uint32_t id)
+{
+	for (Block &b : blocks) {
+		uint32_t age = (id - b.id) & BLOCK_MASK;
+		if (b.used && b.dataMask != b.deliveredMask && age > 0 &&
+		    age < (1u << (BLOCK_BITS - 1))) {
+			deliver(b, true);
+		}
+	}
+}
+
+void FecDecoder::receive(const Packet &packet)
+{
+	const FecConfig &c = owner.config;
+	uint32_t tag = (uint32_t)packet.acknum;
+	bool isParity = (tag & TAG_PARITY) != 0;
+	int pos = tag & 0xff;
+	if (!(tag & TAG_FEC) || pos >= (isParity ? c.r : c.k)) {
+		upper->receive(packet); //没有合法的标记，交给接收方按校验和丢弃
+		return;
+	}
+	uint32_t id = (tag >> 8) & BLOCK_MASK;
+	Block *b = blockFor(id);
+	if (c.hold > 0) {
+		//后面的块已经开始到达，前面块中的缺口不会再由校验报文补上了
+		releaseBefore(id);
+	}
+	if (isParity) {
+		if (b && !b->done) {
+			toSymbol(packet, &b->parity[(size_t)pos * SYMBOL_SIZE]);
+			b->parityMask |= 1u << pos;
+			tryDecode(*b);
+			armHold(*b);
+		}
+		return;
+	}
+
+	Packet pkt(packet);
+	pkt.acknum = -1;
+	//只把校验和正确的报文当作收到，损坏的和丢失的一样由校验报文恢复
+	if (!b || pUtils->calculateCheckSum(pkt) != pkt.checksum) {
+		upper->receive(pkt);
+		return;
+	}
+	if (b->dataMask & (1ull << pos)) {
+		owner.stats.suppressed++; //已经恢复过，或者是信道复制出来的
+		return;
+	}
+	toSymbol(pkt, &b->data[(size_t)pos * SYMBOL_SIZE]);
+	b->dataMask |= 1ull << pos;
+	if (c.hold > 0) {
+		deliver(*b, false);
+	} else {
+		b->deliveredMask |= 1ull << pos;
+		upper->receive(pkt);
+	}
+	tryDecode(*b);
+	armHold(*b);
+}
+
+void FecDecoder::armHold(const Block &b)
+{
+	if (b.dataMask != b.deliveredMask && !holdTimer) {
+		owner.inner->startTimer(RECEIVER, owner.config.hold, HOLD_TIMER);
+		holdTimer = true;
+	}
+}
+
+void FecDecoder::tryDecode(Block &b)
+{
+	const FecConfig &c = owner.config;
+	if (b.done) {
+		return;
+	}
+	int missing[FecConfig::MAX_K];
+	int m = 0;
+	for (int i = 0; i < c.k; i++) {
+		if (!(b.dataMask & (1ull << i))) {
+			missing[m++] = i;
+		}
+	}
+	if (m == 0) {
+		b.done = true;
+		return;
+	}
+	int rows[FecConfig::MAX_R];
+	int n = 0;
+	for (int j = 0; j < c.r && n < m; j++) {
+		if (b.parityMask & (1u << j)) {
+			rows[n++] = j;
+		}
+	}
+	if (n < m) {
+		return;
+	}
+	b.done = true;
+
+	//s_a = p_rows[a] - sum(c(rows[a], i) * d_i)，i为收到的数据报文；再解方程组A * d_missing = s
+	std::vector<uint8_t> s((size_t)m * SYMBOL_SIZE);
+	for (int a = 0; a < m; a++) {
+		uint8_t *sa = &s[(size_t)a * SYMBOL_SIZE];
+		memcpy(sa, &b.parity[(size_t)rows[a] * SYMBOL_SIZE], SYMBOL_SIZE);
+		for (int i = 0; i < c.k; i++) {
+			if (b.dataMask & (1ull << i)) {
+				gf.mulAdd(sa, &b.data[(size_t)i * SYMBOL_SIZE],
+					  coefficient(c, rows[a], i), SYMBOL_SIZE);
+			}
+		}
+	}
+	std::vector<uint8_t> a((size_t)m * m);
+	for (int row = 0; row < m; row++) {
+		for (int col = 0; col < m; col++) {
+			a[row * m + col] = coefficient(c, rows[row], missing[col]);
+		}
+	}
+	if (!invert(a, m)) {
+		return;
+	}
+	Packet pkt;
+	for (int x = 0; x < m; x++) {
+		uint8_t *sym = &b.data[(size_t)missing[x] * SYMBOL_SIZE];
+		memset(sym, 0, SYMBOL_SIZE);
+		for (int y = 0; y < m; y++) {
+			gf.mulAdd(sym, &s[(size_t)y * SYMBOL_SIZE], a[x * m + y],
+				  SYMBOL_SIZE);
+		}
+		fromSymbol(sym, pkt);
+		pkt.acknum = -1;
+		if (pUtils->calculateCheckSum(pkt) != pkt.checksum) {
+			owner.stats.failed++;
+			continue;
+		}
+		b.dataMask |= 1ull << missing[x];
+		owner.stats.recovered++;
+		if (c.hold == 0) {
+			b.deliveredMask |= 1ull << missing[x];
+			upper->receive(pkt);
+		}
+	}
+	if (c.hold > 0) {
+		deliver(b, false);
+	}
+}
+
+void FecDecoder::timeoutHandler(int seqNum)
+{
+	if (seqNum != HOLD_TIMER) {
+		upper->timeoutHandler(seqNum);
+		return;
+	}
+	//等得太久，缺口交给协议自己的重传去补
+	holdTimer = false;
+	for (Block &b : blocks) {
+		if (b.used && b.dataMask != b.deliveredMask) {
+			deliver(b, true);
+		}
+	}
+}
+
+/* ---------------- FecNetwork ---------------- */
+
+FecNetwork::FecNetwork(NetworkService *network, const FecConfig &c)
+	: inner(network)
+	, config(c)
+	, decoder(*this)
+	, blockId(0)
+	, filled(0)
+	, parity((size_t)c.r * SYMBOL_SIZE, 0)
+	, runMode(0)
+{
+}
+
+FecNetwork::~FecNetwork()
+{
+	delete inner;
+}
+
+void FecNetwork::startTimer(RandomEventTarget target, int timeOut, int seqNum)
+{
+	inner->startTimer(target, timeOut, seqNum);
+}
+
+void FecNetwork::stopTimer(RandomEventTarget target, int seqNum)
+{
+	inner->stopTimer(target, seqNum);
+}
+
+void FecNetwork::sendToNetworkLayer(RandomEventTarget target, Packet pkt)
+{
+	if (target != RECEIVER) {
+		inner->sendToNetworkLayer(target, pkt);
+		return;
+	}
+	uint8_t sym[SYMBOL_SIZE];
+	toSymbol(pkt, sym);
+	for (int j = 0; j < config.r; j++) {
+		gf.mulAdd(&parity[(size_t)j * SYMBOL_SIZE], sym,
+			  coefficient(config, j, filled), SYMBOL_SIZE);
+	}
+	pkt.acknum = makeTag(false, blockId, filled);
+	stats.dataPackets++;
+	inner->sendToNetworkLayer(RECEIVER, pkt);
+	if (++filled < config.k) {
+		return;
+	}
+	for (int j = 0; j < config.r; j++) {
+		Packet p;
+		fromSymbol(&parity[(size_t)j * SYMBOL_SIZE], p);
+		p.acknum = makeTag(true, blockId, j);
+		stats.parityPackets++;
+		inner->sendToNetworkLayer(RECEIVER, p);
+	}
+	memset(parity.data(), 0, parity.size());
+	filled = 0;
+	blockId = (blockId + 1) & BLOCK_MASK;
+}
+
+void FecNetwork::delivertoAppLayer(RandomEventTarget target, Message msg)
+{
+	inner->delivertoAppLayer(target, msg);
+}
+
+void FecNetwork::init()
+{
+	inner->init();
+}
+
+void FecNetwork::start()
+{
+	inner->start();
+	if (runMode != 2) {
+		printf("FEC %s(k=%d, r=%d): 数据报文 %ld，校验报文 %ld，恢复 %ld，恢复失败 %ld\n",
+		       config.code == FEC_XOR ? "XOR" : "RS", config.k, config.r,
+		       stats.dataPackets, stats.parityPackets, stats.recovered,
+		       stats.failed);
+	}
+}
+
+void FecNetwork::setRtdSender(RdtSender *ps)
+{
+	inner->setRtdSender(ps);
+}
+
+void FecNetwork::setRtdReceiver(RdtReceiver *pr)
+{
+	decoder.setReceiver(pr);
+	inner->setRtdReceiver(&decoder);
+}
+
+void FecNetwork::setInputFile(const char *ifile)
+{
+	inner->setInputFile(ifile);
+}
+
+void FecNetwork::setOutputFile(const char *ofile)
+{
+	inner->setOutputFile(ofile);
+}
+
+void FecNetwork::setRunMode(int mode)
+{
+	runMode = mode;
+	inner->setRunMode(mode);
+}
+
+double FecNetwork::now() const
+{
+	const SimClock *clock = SimClock::of(inner);
+	return clock ? clock->now() : 0;
+}
@@ -1,9 +1,10 @@
 #include "../include/GBNRdtReceiver.h"
 #include "../include/utils.h"
+#include "../include/Trace.h"
 
-GBNRdtReceiver::GBNRdtReceiver(int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
+GBNRdtReceiver::GBNRdtReceiver(int seqNumBits, const AckPolicy &ack)
+	: seqSpace(seqNumBits)
+	, delayedAck(ack)
 {
 	expectedSeqNum = 0;
 	lastAckPkt = makeAckPkt(-1);
@@ -15,30 +16,50 @@ GBNRdtReceiver::~GBNRdtReceiver()
 
 void GBNRdtReceiver::receive(const Packet &packet)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("receiver window:\n");
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("receiver window:\n");
 	int checkSum = pUtils->calculateCheckSum(packet);
 	if (checkSum == packet.checksum && expectedSeqNum == packet.seqnum) {
-		pUtils->printPacket("receiver got data packet correctly",
+		TRACE_PACKET("receiver got data packet correctly",
 				    packet);
 		Message msg;
 		memcpy(msg.data, packet.payload, sizeof(packet.payload));
 		pns->delivertoAppLayer(RECEIVER, msg);
 		lastAckPkt = makeAckPkt(expectedSeqNum);
-		pUtils->printPacket("receiver sent ACK packet", lastAckPkt);
-		expectedSeqNum = (expectedSeqNum + 1) % MAX_SEQ;
+		expectedSeqNum = seqSpace.next(expectedSeqNum);
+		//累积确认：推迟的ACK被下一个ACK覆盖，不需要单独补发
+		if (!delayedAck.onInOrder()) {
+			TRACE_PACKET("receiver delayed ACK packet", lastAckPkt);
+			TRACE("---------------------------------------------------------------\n\n");
+			return;
+		}
+		TRACE_PACKET("receiver sent ACK packet", lastAckPkt);
 	} else {
 		if (checkSum != packet.checksum)
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"receiver got data packet incorrectly due to incorrect data",
 				packet);
 		else
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"receiver got data packet incorrectly due to incorrect seqnum",
 				packet);
-		pUtils->printPacket("receiver resent ACK packet", lastAckPkt);
+		//延迟确认时不为损坏的报文重发ACK：序号不可信，发送方靠超时或后续的ACK恢复
+		if (checkSum != packet.checksum && delayedAck.enabled()) {
+			TRACE("---------------------------------------------------------------\n\n");
+			return;
+		}
+		TRACE_PACKET("receiver resent ACK packet", lastAckPkt);
 	}
+	delayedAck.sent();
 	//调用模拟网络环境的sendToNetworkLayer，通过网络层发送上次的确认报文
 	pns->sendToNetworkLayer(SENDER, lastAckPkt);
-	printf("---------------------------------------------------------------\n\n");
+	TRACE("---------------------------------------------------------------\n\n");
+}
+
+void GBNRdtReceiver::timeoutHandler(int)
+{
+	if (delayedAck.onTimeout()) {
+		TRACE_PACKET("receiver sent delayed ACK packet", lastAckPkt);
+		pns->sendToNetworkLayer(SENDER, lastAckPkt);
+	}
 }
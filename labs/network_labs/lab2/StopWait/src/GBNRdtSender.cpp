@@ -1,11 +1,12 @@
 #include "../include/Global.h"
 #include "../include/GBNRdtSender.h"
+#include "../include/Checksum.h"
 #include "../include/utils.h"
+#include "../include/Trace.h"
 
 GBNRdtSender::GBNRdtSender(int n, int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
-	, N(n)
+	: seqSpace(seqNumBits)
+	, N(seqSpace.window(n, false))
 {
 	base = 0;
 	nextSeqNum = 0;
@@ -17,7 +18,7 @@ GBNRdtSender::~GBNRdtSender()
 
 bool GBNRdtSender::getWaitingState()
 {
-	return (nextSeqNum == (base + N) % MAX_SEQ);
+	return seqSpace.distance(base, nextSeqNum) >= (uint32_t)N;
 }
 
 bool GBNRdtSender::send(const Message &message)
@@ -29,11 +30,12 @@ bool GBNRdtSender::send(const Message &message)
 	Packet pkt = makeDataPkt(nextSeqNum, message.data);
 	pkts[nextSeqNum] = pkt;
 	pns->sendToNetworkLayer(RECEIVER, pkt);
-	pUtils->printPacket("sender sent data packet", pkt);
+	TRACE_PACKET("sender sent data packet", pkt);
+	rtt.onSend(nextSeqNum);
 
-	nextSeqNum = (nextSeqNum + 1) % MAX_SEQ;
-	if (nextSeqNum == ((base + 1) % MAX_SEQ)) {
-		pns->startTimer(SENDER, Configuration::TIME_OUT, 0);
+	nextSeqNum = seqSpace.next(nextSeqNum);
+	if (nextSeqNum == (seqSpace.next(base))) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
 	}
 
 	return true;
@@ -41,41 +43,110 @@ bool GBNRdtSender::send(const Message &message)
 
 void GBNRdtSender::receive(const Packet &ackPkt)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("sender window:\n");
-	for (int i = base; i != nextSeqNum; i = (i + 1) % MAX_SEQ) {
-		printf("%d ", pkts[i].seqnum);
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("sender window:\n");
+	if (TRACE_ENABLED) {
+		for (int i = base; i != nextSeqNum; i = seqSpace.next(i)) {
+			TRACE("%d ", pkts[i].seqnum);
+		}
 	}
-	printf("\n");
+	TRACE("\n");
 
 	if (ackPkt.checksum == pUtils->calculateCheckSum(ackPkt)) {
-		base = (ackPkt.acknum + 1) %
-		       MAX_SEQ; //由于累计确认，后面的报文段收到能够说明前面的报文段运送正确
-		if (pkts.count(ackPkt.acknum)) {
-			pkts.erase(ackPkt.acknum);
-		}
-		pUtils->printPacket("sender got ACK packet correctly", ackPkt);
-		if (base == nextSeqNum) {
-			pns->stopTimer(SENDER, 0);
+		//只接受确认了窗口内报文的ACK，过时的ACK不能让窗口回退
+		if (seqSpace.inRange(ackPkt.acknum, base,
+				     seqSpace.distance(base, nextSeqNum))) {
+			if (rtt.isTiming() &&
+			    seqSpace.inRange(rtt.getTimedSeq(), base,
+					     seqSpace.distance(base, ackPkt.acknum) + 1)) {
+				rtt.onAck();
+			}
+			rtt.onNewAck();
+			base = seqSpace.next(
+				ackPkt.acknum); //由于累计确认，后面的报文段收到能够说明前面的报文段运送正确
+			restartTimer();
 		}
+		TRACE_PACKET("sender got ACK packet correctly", ackPkt);
 	} else {
-		pUtils->printPacket("sender got ACK packet incorrectly",
+		TRACE_PACKET("sender got ACK packet incorrectly",
 				    ackPkt);
 	}
-	printf("---------------------------------------------------------------\n\n");
+	TRACE("---------------------------------------------------------------\n\n");
+}
+
+void GBNRdtSender::restartTimer()
+{
+	//否则定时器会在窗口一直非空时周期性地超时
+	pns->stopTimer(SENDER, 0);
+	if (base != nextSeqNum) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
+	}
+}
+
+int GBNRdtSender::sendBatch(Span<const Message> messages)
+{
+	uint32_t room = N - seqSpace.distance(base, nextSeqNum);
+	size_t n = messages.size() < room ? messages.size() : room;
+	bool idle = base == nextSeqNum;
+	for (size_t i = 0; i < n; i++) {
+		Packet &pkt = pkts[nextSeqNum];
+		pkt = makeDataPkt(nextSeqNum, messages[i].data);
+		pns->sendToNetworkLayer(RECEIVER, pkt);
+		TRACE_PACKET("sender sent data packet", pkt);
+		rtt.onSend(nextSeqNum);
+		nextSeqNum = seqSpace.next(nextSeqNum);
+	}
+	if (idle && n > 0) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
+	}
+	return (int)n;
+}
+
+void GBNRdtSender::receiveBatch(Span<const Packet> ackPkts)
+{
+	//找出窗口内确认得最远的ACK，效果与逐个处理相同，但窗口只移动一次、定时器只重启一次
+	uint32_t outstanding = seqSpace.distance(base, nextSeqNum);
+	uint32_t acked = 0;
+	int ackNum = base;
+	ackSums.resize(ackPkts.size());
+	checksumBatch(ackPkts.data(), (int)ackPkts.size(), ackSums.data());
+	for (size_t i = 0; i < ackPkts.size(); i++) {
+		const Packet &ackPkt = ackPkts[i];
+		if (ackPkt.checksum != ackSums[i]) {
+			TRACE_PACKET("sender got ACK packet incorrectly", ackPkt);
+			continue;
+		}
+		TRACE_PACKET("sender got ACK packet correctly", ackPkt);
+		if (seqSpace.inRange(ackPkt.acknum, base, outstanding) &&
+		    seqSpace.distance(base, ackPkt.acknum) + 1 > acked) {
+			acked = seqSpace.distance(base, ackPkt.acknum) + 1;
+			ackNum = ackPkt.acknum;
+		}
+	}
+	if (acked == 0) {
+		return;
+	}
+	if (rtt.isTiming() &&
+	    seqSpace.inRange(rtt.getTimedSeq(), base, acked)) {
+		rtt.onAck();
+	}
+	rtt.onNewAck();
+	base = seqSpace.next(ackNum);
+	restartTimer();
 }
 
 void GBNRdtSender::timeoutHandler(int seqNum)
 {
-	int n = ((nextSeqNum - base) + MAX_SEQ) % MAX_SEQ;
-	printf("timeout,resend %d packets,seqnum from %d to %d", n, base,
-	       nextSeqNum - 1);
+	uint32_t n = seqSpace.distance(base, nextSeqNum);
+	TRACE("timeout,resend %u packets,seqnum from %d to %d", n, base,
+	      seqSpace.add(nextSeqNum, -1));
 	pns->stopTimer(SENDER, 0);
+	rtt.onTimeout();
 
-	for (int i = base; i != nextSeqNum; i = (i + 1) % MAX_SEQ) {
+	for (int i = base; i != nextSeqNum; i = seqSpace.next(i)) {
 		pns->sendToNetworkLayer(RECEIVER, pkts[i]);
-		pUtils->printPacket("packet resent", pkts[i]);
+		TRACE_PACKET("packet resent", pkts[i]);
 	}
 
-	pns->startTimer(SENDER, Configuration::TIME_OUT, 0);
+	pns->startTimer(SENDER, rtt.timeout(), 0);
 }
\ No newline at end of file
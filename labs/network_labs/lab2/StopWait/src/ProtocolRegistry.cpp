@@ -0,0 +1,129 @@
+#include "../include/Global.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/StopWaitRdtSender.h"
+#include "../include/StopWaitRdtReceiver.h"
+#include "../include/GBNRdtSender.h"
+#include "../include/GBNRdtReceiver.h"
+#include "../include/SRRdtSender.h"
+#include "../include/SRRdtReceiver.h"
+#include "../include/TCPRdtSender.h"
+#include "../include/TCPRdtReceiver.h"
+#include "../include/SeqNum.h"
+#include <strings.h>
+
+static RdtPair createStopWait(const ProtocolOptions &)
+{
+	RdtPair pair;
+	pair.sender = new StopWaitRdtSender();
+	pair.receiver = new StopWaitRdtReceiver();
+	return pair;
+}
+
+static RdtPair createGBN(const ProtocolOptions &o)
+{
+	RdtPair pair;
+	pair.sender = new GBNRdtSender(o.window, o.seqNumBits);
+	pair.receiver = new GBNRdtReceiver(o.seqNumBits, o.ack);
+	return pair;
+}
+
+static RdtPair createSR(const ProtocolOptions &o)
+{
+	RdtPair pair;
+	pair.sender = new SRRdtSender(o.window, o.seqNumBits);
+	pair.receiver = new SRRdtReceiver(o.window, o.seqNumBits, o.ack);
+	return pair;
+}
+
+static RdtPair createTCP(const ProtocolOptions &o)
+{
+	RdtPair pair;
+	pair.sender = new TCPRdtSender(o.window, o.seqNumBits, true);
+	pair.receiver = new TCPRdtReceiver(o.seqNumBits, o.window, o.ack);
+	return pair;
+}
+
+static RdtPair createTCPNoSack(const ProtocolOptions &o)
+{
+	RdtPair pair;
+	pair.sender = new TCPRdtSender(o.window, o.seqNumBits, false);
+	pair.receiver = new TCPRdtReceiver(o.seqNumBits, o.window, o.ack);
+	return pair;
+}
+
+//内置协议直接放在表里，不依赖静态对象的构造顺序，也不会被链接器丢掉
+std::vector<ProtocolRegistry::Entry> &ProtocolRegistry::entries()
+{
+	static std::vector<Entry> table = {
+		{ "StopWait", "stop-and-wait (rdt3.0), ignores window and sequence bits", createStopWait, WINDOW_ANY },
+		{ "GBN", "Go-Back-N", createGBN, WINDOW_CUMULATIVE },
+		{ "SR", "Selective Repeat", createSR, WINDOW_SELECTIVE },
+		{ "TCP", "TCP-like: cumulative ACKs, fast retransmit, Reno/NewReno, SACK", createTCP, WINDOW_SELECTIVE },
+		{ "TCP-NOSACK", "TCP without SACK blocks", createTCPNoSack, WINDOW_SELECTIVE },
+	};
+	return table;
+}
+
+ProtocolRegistry::Entry *ProtocolRegistry::find(const char *name)
+{
+	for (Entry &e : entries()) {
+		if (strcasecmp(e.name.c_str(), name) == 0) {
+			return &e;
+		}
+	}
+	return nullptr;
+}
+
+void ProtocolRegistry::add(const char *name, const char *description,
+			   ProtocolFactory factory, WindowLimit limit)
+{
+	Entry *e = find(name);
+	if (e) {
+		e->description = description;
+		e->factory = factory;
+		e->limit = limit;
+	} else {
+		entries().push_back({ name, description, factory, limit });
+	}
+}
+
+bool ProtocolRegistry::has(const char *name)
+{
+	return find(name) != nullptr;
+}
+
+bool ProtocolRegistry::create(const char *name, const ProtocolOptions &options,
+			      RdtPair &pair)
+{
+	const Entry *e = find(name);
+	if (e == nullptr) {
+		return false;
+	}
+	pair = e->factory(options);
+	return true;
+}
+
+int ProtocolRegistry::maxWindow(const char *name, int seqNumBits)
+{
+	const Entry *e = find(name);
+	if (e == nullptr || e->limit == WINDOW_ANY) {
+		return 0;
+	}
+	return SeqSpace(seqNumBits).window(0, e->limit == WINDOW_SELECTIVE);
+}
+
+std::vector<std::string> ProtocolRegistry::names()
+{
+	std::vector<std::string> result;
+	for (const Entry &e : entries()) {
+		result.push_back(e.name);
+	}
+	return result;
+}
+
+void ProtocolRegistry::list(FILE *out)
+{
+	for (const Entry &e : entries()) {
+		fprintf(out, "  %-12s %s\n", e.name.c_str(), e.description.c_str());
+	}
+}
@@ -0,0 +1,104 @@
+#include "../include/Global.h"
+#include "../include/RttEstimator.h"
+#include <math.h>
+
+static const double ALPHA = 1.0 / 8;
+static const double BETA = 1.0 / 4;
+static const double K = 4;
+static const double GRANULARITY = 1; //定时器的最小单位，startTimer只接受整数时长
+
+thread_local int RttEstimator::baseTimeout = 0;
+
+RttEstimator::RttEstimator()
+	: clock(nullptr)
+	, clockResolved(false)
+	, minRto(baseTimeout)
+	, srtt(0)
+	, rttvar(0)
+	, rto(baseTimeout > 0 ? baseTimeout : Configuration::TIME_OUT)
+	, hasSample(false)
+	, backoff(1)
+	, timing(false)
+	, timedSeq(0)
+	, timedAt(0)
+{
+}
+
+const SimClock *SimClock::of(const NetworkService *ns)
+{
+	const SimClock *c = dynamic_cast<const SimClock *>(ns);
+	return c && c->hasClock() ? c : nullptr;
+}
+
+const SimClock *RttEstimator::getClock()
+{
+	//构造发送方时pns可能还没有设置好，第一次用到时再查找
+	if (!clockResolved) {
+		clock = SimClock::of(pns);
+		clockResolved = true;
+	}
+	return clock;
+}
+
+void RttEstimator::onSend(int seq)
+{
+	if (timing) {
+		return;
+	}
+	const SimClock *c = getClock();
+	timing = true;
+	timedSeq = seq;
+	timedAt = c ? c->now() : 0;
+}
+
+void RttEstimator::onAck()
+{
+	if (!timing) {
+		return;
+	}
+	timing = false;
+	const SimClock *c = getClock();
+	if (!c) {
+		return;
+	}
+
+	double r = c->now() - timedAt;
+	if (!hasSample) {
+		srtt = r;
+		rttvar = r / 2;
+		hasSample = true;
+	} else {
+		rttvar = (1 - BETA) * rttvar + BETA * fabs(srtt - r);
+		srtt = (1 - ALPHA) * srtt + ALPHA * r;
+	}
+	rto = srtt + (K * rttvar > GRANULARITY ? K * rttvar : GRANULARITY);
+	if (rto < minRto) {
+		rto = minRto;
+	}
+}
+
+void RttEstimator::onNewAck()
+{
+	if (hasSample || !getClock()) {
+		backoff = 1;
+	}
+}
+
+void RttEstimator::cancel()
+{
+	timing = false;
+}
+
+void RttEstimator::onTimeout()
+{
+	timing = false;
+	if (backoff < MAX_BACKOFF) {
+		backoff *= 2;
+	}
+}
+
+int RttEstimator::timeout() const
+{
+	int t = (int)ceil(rto * backoff);
+	return t > 0 ? t : 1;
+}
@@ -1,11 +1,15 @@
 #include "../include/SRRdtReceiver.h"
 #include "../include/utils.h"
+#include "../include/Sack.h"
+#include "../include/Trace.h"
 
-SRRdtReceiver::SRRdtReceiver(int n, int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
-	, N(n)
+SRRdtReceiver::SRRdtReceiver(int n, int seqNumBits, const AckPolicy &ack)
+	: seqSpace(seqNumBits)
+	, N(seqSpace.window(n, true))
 	, base(0)
+	, received(seqSpace.slots(Configuration::MAX_WINDOW_SIZE))
+	, delayedAck(ack)
+	, ackFrom(0)
 {
 }
 
@@ -15,70 +19,77 @@ SRRdtReceiver::~SRRdtReceiver()
 
 inline bool SRRdtReceiver::inWindow(int seqNum)
 {
-	int start = base;
-	int end = (base + N - 1) % MAX_SEQ;
-	if (start < end) {
-		return start <= seqNum && seqNum <= end;
-	} else {
-		return seqNum >= start || seqNum <= end;
-	}
+	return seqSpace.inRange(seqNum, base, N); // [base, base + N)
 }
 
 inline bool SRRdtReceiver::inPrevWindow(int seqNum)
 {
-	int start = base - N;
-	if (start < 0)
-		start += MAX_SEQ;
-	int end = base - 1;
-	if (end < 0)
-		end += MAX_SEQ;
-	if (start < end) {
-		return start <= seqNum && seqNum <= end;
+	return seqSpace.inRange(seqNum, seqSpace.add(base, -N), N); // [base - N, base)
+}
+
+//确认seqNum；延迟确认时推迟了的报文[ackFrom, base)作为一个SACK块捎带在同一个ACK里
+void SRRdtReceiver::sendAck(int seqNum)
+{
+	Packet ackPkt;
+	if (delayedAck.enabled() && ackFrom != base) {
+		SackBlock block = { ackFrom, base };
+		ackPkt = makeSackAckPkt(seqNum, &block, 1);
 	} else {
-		return seqNum >= start || seqNum <= end;
+		ackPkt = makeAckPkt(seqNum);
 	}
+	ackFrom = base;
+	delayedAck.sent();
+	TRACE_PACKET("receiver sent ACK packet", ackPkt);
+	pns->sendToNetworkLayer(SENDER, ackPkt);
 }
 
 void SRRdtReceiver::receive(const Packet &packet)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("receiver window:\n");
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("receiver window:\n");
 	int checkSum = pUtils->calculateCheckSum(packet);
 	if (checkSum == packet.checksum) {
-		pUtils->printPacket("receiver got data packet correctly",
+		TRACE_PACKET("receiver got data packet correctly",
 				    packet);
 		if (inWindow(packet.seqnum)) {
-			Packet ackPkt = makeAckPkt(packet.seqnum);
-			pns->sendToNetworkLayer(SENDER, ackPkt);
-			if (!cache.count(packet.seqnum)) { // 不在缓存区中
-				if (packet.seqnum == base) {
-					Message msg;
-					memcpy(msg.data, packet.payload,
+			if (!received.test(packet.seqnum)) { // 不在缓存区中
+				cache[received.slot(packet.seqnum)] = packet;
+				received.set(packet.seqnum);
+			}
+			int n = 0;
+			if (packet.seqnum == base) {
+				// 一次扫描找出从base开始连续收到的报文，按序递交
+				n = received.runLength(base, N);
+				Message msg;
+				for (int i = 0; i < n; i++) {
+					memcpy(msg.data,
+					       cache[received.slot(base)].payload,
 					       Configuration::PAYLOAD_SIZE);
 					pns->delivertoAppLayer(RECEIVER, msg);
-					base = (base + 1) % MAX_SEQ;
-					while (cache.count(base)) {
-						memcpy(msg.data,
-						       cache[base].payload,
-						       Configuration::
-							       PAYLOAD_SIZE);
-						pns->delivertoAppLayer(RECEIVER,
-								       msg);
-						cache.erase(base);
-						base = (base + 1) % MAX_SEQ;
-					}
-				} else {
-					cache[packet.seqnum] = packet;
+					received.clear(base);
+					base = seqSpace.next(base);
 				}
 			}
+			//只推迟按序到达的报文的确认，乱序和补上缺口的报文立即确认
+			if (n == 1 && !delayedAck.onInOrder()) {
+				TRACE("receiver delayed ACK %d\n", packet.seqnum);
+			} else {
+				sendAck(packet.seqnum);
+			}
 		} else if (inPrevWindow(packet.seqnum)) {
-			Packet ackPkt = makeAckPkt(packet.seqnum);
-			pns->sendToNetworkLayer(SENDER, ackPkt);
+			sendAck(packet.seqnum);
 		}
 	} else {
-		pUtils->printPacket(
+		TRACE_PACKET(
 			"receiver got data packet incorrectly due to incorrect data",
 			packet);
 	}
-	printf("---------------------------------------------------------------\n\n");
-}
\ No newline at end of file
+	TRACE("---------------------------------------------------------------\n\n");
+}
+
+void SRRdtReceiver::timeoutHandler(int)
+{
+	if (delayedAck.onTimeout() && ackFrom != base) {
+		sendAck(seqSpace.add(base, -1));
+	}
+}
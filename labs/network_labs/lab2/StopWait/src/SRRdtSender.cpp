@@ -1,10 +1,12 @@
 #include "../include/utils.h"
 #include "../include/SRRdtSender.h"
+#include "../include/Checksum.h"
+#include "../include/Sack.h"
+#include "../include/Trace.h"
 
 SRRdtSender::SRRdtSender(int n, int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
-	, N(n)
+	: seqSpace(seqNumBits)
+	, N(seqSpace.window(n, true))
 {
 	base = 0;
 	nextSeqNum = 0;
@@ -16,16 +18,14 @@ SRRdtSender::~SRRdtSender()
 
 inline bool SRRdtSender::inWindow(int ackNum)
 {
-	if (base == nextSeqNum) // base == nextSeqNum == 0
-		return false;
-	if (base < nextSeqNum)
-		return base <= ackNum && ackNum < nextSeqNum;
-	return nextSeqNum > ackNum || ackNum >= base; // 序号循环
+	// [base, nextSeqNum)，用序号算术处理回绕
+	return seqSpace.inRange(ackNum, base,
+				seqSpace.distance(base, nextSeqNum));
 }
 
 bool SRRdtSender::getWaitingState()
 {
-	return nextSeqNum == (base + N) % MAX_SEQ;
+	return seqSpace.distance(base, nextSeqNum) >= (uint32_t)N;
 }
 
 bool SRRdtSender::send(const Message &message)
@@ -35,57 +35,134 @@ bool SRRdtSender::send(const Message &message)
 	}
 	Packet pkt = makeDataPkt(nextSeqNum, message.data);
 	pkts[nextSeqNum] = PacketDocker(pkt, false);
-	pUtils->printPacket("sender sent data packet", pkt);
+	TRACE_PACKET("sender sent data packet", pkt);
 	pns->sendToNetworkLayer(RECEIVER, pkt);
 	// 启动发送方定时器
-	pns->startTimer(SENDER, Configuration::TIME_OUT, nextSeqNum);
-	nextSeqNum = (nextSeqNum + 1) % MAX_SEQ;
-	fflush(stdout);
+	rtt.onSend(nextSeqNum);
+	timers.start(nextSeqNum, rtt.timeout());
+	nextSeqNum = seqSpace.next(nextSeqNum);
+	TRACE_FLUSH();
 	return true;
 }
 
-void SRRdtSender::receive(const Packet &ackPkt)
+int SRRdtSender::sendBatch(Span<const Message> messages)
+{
+	uint32_t room = N - seqSpace.distance(base, nextSeqNum);
+	size_t n = messages.size() < room ? messages.size() : room;
+	for (size_t i = 0; i < n; i++) {
+		PacketDocker &docker = pkts[nextSeqNum];
+		docker.first = makeDataPkt(nextSeqNum, messages[i].data);
+		docker.second = false;
+		TRACE_PACKET("sender sent data packet", docker.first);
+		pns->sendToNetworkLayer(RECEIVER, docker.first);
+		rtt.onSend(nextSeqNum);
+		timers.start(nextSeqNum, rtt.timeout());
+		nextSeqNum = seqSpace.next(nextSeqNum);
+	}
+	TRACE_FLUSH();
+	return (int)n;
+}
+
+void SRRdtSender::ackOne(int seqNum)
+{
+	if (!pkts[seqNum].second) {
+		pkts[seqNum].second = true;
+		timers.stop(seqNum);
+		if (rtt.isTiming() && rtt.getTimedSeq() == seqNum) {
+			rtt.onAck();
+		}
+		rtt.onNewAck();
+	}
+}
+
+bool SRRdtSender::markAcked(const Packet &ackPkt, int checkSum)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("sender window:\n");
-	for (int i = base; i != nextSeqNum; i = (i + 1) % MAX_SEQ)
-		printf("%d ", pkts[i].first.seqnum);
-	printf("\n");
 	// 检查校验和是否正确
-	int checkSum = pUtils->calculateCheckSum(ackPkt);
-	// 如果校验和正确
-	if (checkSum == ackPkt.checksum) {
-		if (inWindow(ackPkt.acknum)) {
-			pUtils->printPacket("sender got ACK packet correctly",
-					    ackPkt);
-			if (!pkts[ackPkt.acknum].second) {
-				pkts[ackPkt.acknum].second = true;
-				pns->stopTimer(SENDER, ackPkt.acknum);
-			}
-			if (ackPkt.acknum == base) {
-				while (base != nextSeqNum &&
-				       pkts[base].second) {
-					pkts.erase(base);
-					base = (base + 1) % MAX_SEQ;
-				}
+	if (checkSum != ackPkt.checksum) {
+		TRACE_PACKET("sender got ACK packet incorrectly",
+				    ackPkt);
+		return false;
+	}
+	//延迟确认的接收方把推迟确认的报文作为SACK块捎带在ACK里
+	SackBlock blocks[MAX_SACK_BLOCKS];
+	int n = getSackBlocks(ackPkt, blocks);
+	for (int b = 0; b < n; b++) {
+		uint32_t len = seqSpace.distance(blocks[b].start, blocks[b].end);
+		for (uint32_t i = 0; i < len && i < (uint32_t)N; i++) {
+			int seq = seqSpace.add(blocks[b].start, i);
+			if (inWindow(seq)) {
+				ackOne(seq);
 			}
-		} else {
-			pUtils->printPacket(
-				"sender got ACK packet correctly,but not in the window",
-				ackPkt);
 		}
+	}
+	if (!inWindow(ackPkt.acknum)) {
+		TRACE_PACKET(
+			"sender got ACK packet correctly,but not in the window",
+			ackPkt);
 	} else {
-		pUtils->printPacket("sender got ACK packet incorrectly",
-				    ackPkt);
+		TRACE_PACKET("sender got ACK packet correctly", ackPkt);
+		ackOne(ackPkt.acknum);
 	}
-	fflush(stdout);
-	printf("---------------------------------------------------------------\n\n");
+	return base != nextSeqNum && pkts[base].second;
 }
 
-void SRRdtSender::timeoutHandler(int seqNum)
+void SRRdtSender::slideWindow()
 {
-	pns->stopTimer(SENDER, seqNum);
+	while (base != nextSeqNum && pkts[base].second) {
+		base = seqSpace.next(base);
+	}
+}
+
+void SRRdtSender::receive(const Packet &ackPkt)
+{
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("sender window:\n");
+	if (TRACE_ENABLED) {
+		for (int i = base; i != nextSeqNum; i = seqSpace.next(i))
+			TRACE("%d ", pkts[i].first.seqnum);
+	}
+	TRACE("\n");
+	if (markAcked(ackPkt, pUtils->calculateCheckSum(ackPkt))) {
+		slideWindow();
+	}
+	TRACE_FLUSH();
+	TRACE("---------------------------------------------------------------\n\n");
+}
+
+void SRRdtSender::receiveBatch(Span<const Packet> ackPkts)
+{
+	bool slide = false;
+	ackSums.resize(ackPkts.size());
+	checksumBatch(ackPkts.data(), (int)ackPkts.size(), ackSums.data());
+	for (size_t i = 0; i < ackPkts.size(); i++) {
+		slide = markAcked(ackPkts[i], ackSums[i]) || slide;
+	}
+	if (slide) {
+		slideWindow();
+	}
+	TRACE_FLUSH();
+}
+
+void SRRdtSender::retransmit(int seqNum)
+{
+	//每个报文各有定时器，一次突发丢包会连续超时多个，只在最早的报文超时时退避一次
+	if (seqNum == base) {
+		rtt.onTimeout();
+	} else if (rtt.isTiming() && rtt.getTimedSeq() == seqNum) {
+		rtt.cancel();
+	}
 	pns->sendToNetworkLayer(RECEIVER, pkts[seqNum].first);
-	pUtils->printPacket("packet resent", pkts[seqNum].first);
-	pns->startTimer(SENDER, Configuration::TIME_OUT, seqNum);
+	TRACE_PACKET("packet resent", pkts[seqNum].first);
+	timers.start(seqNum, rtt.timeout());
+}
+
+void SRRdtSender::timeoutHandler(int)
+{
+	//网络环境中只有时间轮的一个定时器，不按编号过滤：32位序号时报文序号也可能等于TIMER_ID
+	//先取出所有到期的报文再重传，重传时会在轮上重新启动它们的定时器
+	timers.expire(expired);
+	for (int seq : expired) {
+		retransmit(seq);
+	}
+	TRACE_FLUSH();
 }
\ No newline at end of file
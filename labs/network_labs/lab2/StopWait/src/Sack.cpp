@@ -0,0 +1,23 @@
+#include "../include/Sack.h"
+#include "../include/utils.h"
+
+Packet makeSackAckPkt(int ackNum, const SackBlock *blocks, int n)
+{
+	char data[Configuration::PAYLOAD_SIZE] = "ACK";
+	if (n > MAX_SACK_BLOCKS) {
+		n = MAX_SACK_BLOCKS;
+	}
+	data[SACK_COUNT_OFFSET] = (char)n;
+	memcpy(data + SACK_BLOCK_OFFSET, blocks, n * sizeof(SackBlock));
+	return makePkt(-1, ackNum, data);
+}
+
+int getSackBlocks(const Packet &ackPkt, SackBlock *blocks)
+{
+	int n = ackPkt.payload[SACK_COUNT_OFFSET];
+	if (n <= 0 || n > MAX_SACK_BLOCKS) {
+		return 0;
+	}
+	memcpy(blocks, ackPkt.payload + SACK_BLOCK_OFFSET, n * sizeof(SackBlock));
+	return n;
+}
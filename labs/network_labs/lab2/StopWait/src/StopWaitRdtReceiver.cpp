@@ -1,6 +1,7 @@
 
 #include "Global.h"
 #include "StopWaitRdtReceiver.h"
+#include "Trace.h"
 
 StopWaitRdtReceiver::StopWaitRdtReceiver()
 	: expectSequenceNumberRcvd(0)
@@ -27,7 +28,7 @@ void StopWaitRdtReceiver::receive(const Packet &packet)
 	//如果校验和正确，同时收到报文的序号等于接收方期待收到的报文序号一致
 	if (checkSum == packet.checksum &&
 	    this->expectSequenceNumberRcvd == packet.seqnum) {
-		pUtils->printPacket("接收方正确收到发送方的报文", packet);
+		TRACE_PACKET("接收方正确收到发送方的报文", packet);
 
 		//取出Message，向上递交给应用层
 		Message msg;
@@ -36,7 +37,7 @@ void StopWaitRdtReceiver::receive(const Packet &packet)
 
 		lastAckPkt.acknum = packet.seqnum; //确认序号等于收到的报文序号
 		lastAckPkt.checksum = pUtils->calculateCheckSum(lastAckPkt);
-		pUtils->printPacket("接收方发送确认报文", lastAckPkt);
+		TRACE_PACKET("接收方发送确认报文", lastAckPkt);
 		pns->sendToNetworkLayer(
 			SENDER,
 			lastAckPkt); //调用模拟网络环境的sendToNetworkLayer，通过网络层发送确认报文到对方
@@ -46,15 +47,15 @@ void StopWaitRdtReceiver::receive(const Packet &packet)
 			this->expectSequenceNumberRcvd; //接收序号在0-1之间切换
 	} else {
 		if (checkSum != packet.checksum) {
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"接收方没有正确收到发送方的报文,数据校验错误",
 				packet);
 		} else {
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"接收方没有正确收到发送方的报文,报文序号不对",
 				packet);
 		}
-		pUtils->printPacket("接收方重新发送上次的确认报文", lastAckPkt);
+		TRACE_PACKET("接收方重新发送上次的确认报文", lastAckPkt);
 		pns->sendToNetworkLayer(
 			SENDER,
 			lastAckPkt); //调用模拟网络环境的sendToNetworkLayer，通过网络层发送上次的确认报文
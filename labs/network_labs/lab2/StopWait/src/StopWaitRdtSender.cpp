@@ -1,6 +1,7 @@
 
 #include "Global.h"
 #include "StopWaitRdtSender.h"
+#include "Trace.h"
 
 StopWaitRdtSender::StopWaitRdtSender()
 	: expectSequenceNumberSend(0)
@@ -30,8 +31,9 @@ bool StopWaitRdtSender::send(const Message &message)
 	       sizeof(message.data));
 	this->packetWaitingAck.checksum =
 		pUtils->calculateCheckSum(this->packetWaitingAck);
-	pUtils->printPacket("发送方发送报文", this->packetWaitingAck);
-	pns->startTimer(SENDER, Configuration::TIME_OUT,
+	TRACE_PACKET("发送方发送报文", this->packetWaitingAck);
+	rtt.onSend(this->packetWaitingAck.seqnum);
+	pns->startTimer(SENDER, rtt.timeout(),
 			this->packetWaitingAck.seqnum); //启动发送方定时器
 	pns->sendToNetworkLayer(
 		RECEIVER,
@@ -55,18 +57,21 @@ void StopWaitRdtSender::receive(const Packet &ackPkt)
 				1 -
 				this->expectSequenceNumberSend; //下一个发送序号在0-1之间切换
 			this->waitingState = false;
-			pUtils->printPacket("发送方正确收到确认", ackPkt);
+			rtt.onAck();
+			rtt.onNewAck();
+			TRACE_PACKET("发送方正确收到确认", ackPkt);
 			pns->stopTimer(
 				SENDER,
 				this->packetWaitingAck.seqnum); //关闭定时器
 		} else {
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"发送方没有正确收到确认，重发上次发送的报文",
 				this->packetWaitingAck);
 			pns->stopTimer(
 				SENDER,
 				this->packetWaitingAck.seqnum); //首先关闭定时器
-			pns->startTimer(SENDER, Configuration::TIME_OUT,
+			rtt.cancel(); //重发后的确认不能用来估计RTT
+			pns->startTimer(SENDER, rtt.timeout(),
 					this->packetWaitingAck
 						.seqnum); //重新启动发送方定时器
 			pns->sendToNetworkLayer(
@@ -79,10 +84,11 @@ void StopWaitRdtSender::receive(const Packet &ackPkt)
 void StopWaitRdtSender::timeoutHandler(int seqNum)
 {
 	//唯一一个定时器,无需考虑seqNum
-	pUtils->printPacket("发送方定时器时间到，重发上次发送的报文",
+	TRACE_PACKET("发送方定时器时间到，重发上次发送的报文",
 			    this->packetWaitingAck);
 	pns->stopTimer(SENDER, seqNum); //首先关闭定时器
-	pns->startTimer(SENDER, Configuration::TIME_OUT,
+	rtt.onTimeout(); //超时时间加倍
+	pns->startTimer(SENDER, rtt.timeout(),
 			seqNum); //重新启动发送方定时器
 	pns->sendToNetworkLayer(RECEIVER,
 				this->packetWaitingAck); //重新发送数据包
@@ -1,9 +1,12 @@
 #include "../include/TCPRdtReceiver.h"
 #include "../include/utils.h"
+#include "../include/Trace.h"
 
-TCPRdtReceiver::TCPRdtReceiver(int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
+TCPRdtReceiver::TCPRdtReceiver(int seqNumBits, int n, const AckPolicy &ack)
+	: seqSpace(seqNumBits)
+	, N(seqSpace.window(n, true))
+	, received(seqSpace.slots(Configuration::MAX_WINDOW_SIZE))
+	, delayedAck(ack)
 {
 	expectedSeqNum = 0;
 	lastAckPkt = makeAckPkt(-1);
@@ -13,32 +16,117 @@ TCPRdtReceiver::~TCPRdtReceiver()
 {
 }
 
+int TCPRdtReceiver::sackBlocks(int latest, SackBlock *blocks) const
+{
+	SackBlock latestBlock;
+	SackBlock others[MAX_SACK_BLOCKS];
+	bool found = false;
+	int count = 0;
+
+	//expectedSeqNum本身一定没有收到，从它后面开始按字扫描缓存位图，找出各段连续收到的报文
+	int pos = seqSpace.next(expectedSeqNum);
+	int remaining = N - 1;
+	while (remaining > 0) {
+		int gap = received.gapLength(pos, remaining);
+		pos = seqSpace.add(pos, gap);
+		remaining -= gap;
+		if (remaining == 0) {
+			break;
+		}
+		int run = received.runLength(pos, remaining);
+		SackBlock b = { pos, seqSpace.add(pos, run) };
+		if (!found && seqSpace.inRange(latest, pos, run)) {
+			latestBlock = b;
+			found = true;
+		} else if (count < MAX_SACK_BLOCKS) {
+			others[count++] = b;
+		}
+		if (found && count >= MAX_SACK_BLOCKS - 1) {
+			break;
+		}
+		pos = b.end;
+		remaining -= run;
+	}
+
+	int n = 0;
+	if (found) {
+		blocks[n++] = latestBlock;
+	}
+	for (int i = 0; i < count && n < MAX_SACK_BLOCKS; i++) {
+		blocks[n++] = others[i];
+	}
+	return n;
+}
+
 void TCPRdtReceiver::receive(const Packet &packet)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("receiver window:\n");
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("receiver window:\n");
 	int checkSum = pUtils->calculateCheckSum(packet);
-	if (checkSum == packet.checksum && expectedSeqNum == packet.seqnum) {
-		pUtils->printPacket("receiver got data packet correctly",
+	if (checkSum == packet.checksum &&
+	    seqSpace.inRange(packet.seqnum, expectedSeqNum, N)) {
+		TRACE_PACKET("receiver got data packet correctly",
 				    packet);
-		Message msg;
-		memcpy(msg.data, packet.payload, sizeof(packet.payload));
-		pns->delivertoAppLayer(RECEIVER, msg);
-		lastAckPkt = makeAckPkt(expectedSeqNum);
-		pUtils->printPacket("receiver sent ACK packet", lastAckPkt);
-		expectedSeqNum = (expectedSeqNum + 1) % MAX_SEQ;
+		//先缓存乱序到达的报文，等缺口补上后一起按序递交，ACK始终是累积确认
+		if (!received.test(packet.seqnum)) {
+			cache[received.slot(packet.seqnum)] = packet;
+			received.set(packet.seqnum);
+		}
+		int delivered = 0;
+		if (packet.seqnum == expectedSeqNum) {
+			int n = received.runLength(expectedSeqNum, N);
+			delivered = n;
+			Message msg;
+			for (int i = 0; i < n; i++) {
+				memcpy(msg.data,
+				       cache[received.slot(expectedSeqNum)].payload,
+				       Configuration::PAYLOAD_SIZE);
+				pns->delivertoAppLayer(RECEIVER, msg);
+				received.clear(expectedSeqNum);
+				expectedSeqNum = seqSpace.next(expectedSeqNum);
+			}
+		}
+		//乱序报文到达时重复确认，并用SACK块告诉发送方已经缓存了哪些报文
+		SackBlock blocks[MAX_SACK_BLOCKS];
+		int n = sackBlocks(packet.seqnum, blocks);
+		lastAckPkt = makeSackAckPkt(seqSpace.add(expectedSeqNum, -1),
+					    blocks, n);
+		//只有按序到达、后面也没有缓存报文时才推迟确认；补上缺口或乱序时立即确认，发送方靠它们快速重传
+		if (delivered == 1 && n == 0 && !delayedAck.onInOrder()) {
+			TRACE_PACKET("receiver delayed ACK packet", lastAckPkt);
+			TRACE("---------------------------------------------------------------\n\n");
+			return;
+		}
+		TRACE_PACKET("receiver sent ACK packet", lastAckPkt);
+		for (int i = 0; i < n; i++) {
+			TRACE("SACK [%d, %d)\n", blocks[i].start, blocks[i].end);
+		}
 	} else {
 		if (checkSum != packet.checksum)
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"receiver got data packet incorrectly due to incorrect data",
 				packet);
 		else
-			pUtils->printPacket(
+			TRACE_PACKET(
 				"receiver got data packet incorrectly due to incorrect seqnum",
 				packet);
-		pUtils->printPacket("receiver resent ACK packet", lastAckPkt);
+		//延迟确认时不为损坏的报文发重复ACK，免得被发送方当作丢包信号
+		if (checkSum != packet.checksum && delayedAck.enabled()) {
+			TRACE("---------------------------------------------------------------\n\n");
+			return;
+		}
+		TRACE_PACKET("receiver resent ACK packet", lastAckPkt);
 	}
+	delayedAck.sent();
 	//调用模拟网络环境的sendToNetworkLayer，通过网络层发送上次的确认报文
 	pns->sendToNetworkLayer(SENDER, lastAckPkt);
-	printf("---------------------------------------------------------------\n\n");
+	TRACE("---------------------------------------------------------------\n\n");
+}
+
+void TCPRdtReceiver::timeoutHandler(int)
+{
+	if (delayedAck.onTimeout()) {
+		TRACE_PACKET("receiver sent delayed ACK packet", lastAckPkt);
+		pns->sendToNetworkLayer(SENDER, lastAckPkt);
+	}
 }
@@ -1,25 +1,201 @@
 #include "../include/Global.h"
 #include "../include/TCPRdtSender.h"
+#include "../include/Checksum.h"
 #include "../include/utils.h"
+#include "../include/Trace.h"
 
-TCPRdtSender::TCPRdtSender(int n, int seqNumBits)
-	: MAX_SEQ((seqNumBits > 0 && seqNumBits <= 16) ? (1 << seqNumBits) :
-							 (1 << 16))
-	, N(n)
+TCPRdtSender::TCPRdtSender(int n, int seqNumBits, bool sack)
+	: seqSpace(seqNumBits)
+	, N(seqSpace.window(n, true)) //接收方缓存乱序报文，窗口上限与SR相同，否则重传的旧报文可能落进接收窗口
+	, sackEnabled(sack)
+	, sacked(seqSpace.slots(Configuration::MAX_WINDOW_SIZE))
+	, rexmitted(seqSpace.slots(Configuration::MAX_WINDOW_SIZE))
 {
 	base = 0;
 	nextSeqNum = 0;
+	sndNxt = 0;
 	cnt = 0;
 	lastAckNum = 0;
+	cwnd = 1;
+	ssthresh = N;
+	inRecovery = false;
+	recover = 0;
+	highSacked = 0;
+	rexmitCount = 0;
+	holeCursor = 0;
+	sackRecovery = false;
+	batching = false;
+	timerPending = false;
 }
 
 TCPRdtSender::~TCPRdtSender()
 {
 }
 
+int TCPRdtSender::window() const
+{
+	int w = (int)cwnd;
+	if (w < 1) {
+		w = 1;
+	}
+	return w < N ? w : N;
+}
+
+int TCPRdtSender::flightSize() const
+{
+	return (int)seqSpace.distance(base, sndNxt);
+}
+
+int TCPRdtSender::pipe() const
+{
+	if (!sackEnabled) {
+		return flightSize();
+	}
+	//highSacked以下的报文要么已被SACK，要么被认为已经丢失，只有重传出去的还在网络中
+	uint32_t flight = seqSpace.distance(base, sndNxt);
+	uint32_t below = seqSpace.distance(base, highSacked);
+	if (below > flight) {
+		below = flight;
+	}
+	return (int)(flight - below) + rexmitCount;
+}
+
+bool TCPRdtSender::belowHighSacked(int seq) const
+{
+	return seqSpace.inRange(seq, base, seqSpace.distance(base, highSacked));
+}
+
+void TCPRdtSender::updateScoreboard(int oldBase, const Packet &ackPkt)
+{
+	//累积确认覆盖的部分从记分板上清掉，槽位之后会被新的序号复用
+	for (int i = oldBase; i != base; i = seqSpace.next(i)) {
+		sacked.clear(i);
+		if (rexmitted.test(i)) {
+			rexmitted.clear(i);
+			rexmitCount--;
+		}
+	}
+	uint32_t outstanding = seqSpace.distance(base, nextSeqNum);
+	if (seqSpace.distance(base, highSacked) > outstanding) {
+		highSacked = base;
+	}
+	if (seqSpace.distance(base, holeCursor) > outstanding) {
+		holeCursor = base;
+	}
+
+	SackBlock blocks[MAX_SACK_BLOCKS];
+	int n = getSackBlocks(ackPkt, blocks);
+	for (int b = 0; b < n; b++) {
+		//只认[base, nextSeqNum)以内的部分，过时或损坏的块直接忽略
+		uint32_t offset = seqSpace.distance(base, blocks[b].start);
+		uint32_t len = seqSpace.distance(blocks[b].start, blocks[b].end);
+		if (offset >= outstanding || len > outstanding - offset) {
+			continue;
+		}
+		for (int i = blocks[b].start; i != blocks[b].end;
+		     i = seqSpace.next(i)) {
+			if (sacked.test(i)) {
+				continue;
+			}
+			sacked.set(i);
+			if (rexmitted.test(i)) {
+				rexmitted.clear(i);
+				rexmitCount--;
+			}
+		}
+		if (offset + len > seqSpace.distance(base, highSacked)) {
+			highSacked = blocks[b].end;
+		}
+	}
+}
+
+void TCPRdtSender::retransmitHoles()
+{
+	while (pipe() < window()) {
+		while (belowHighSacked(holeCursor) &&
+		       (sacked.test(holeCursor) || rexmitted.test(holeCursor))) {
+			holeCursor = seqSpace.next(holeCursor);
+		}
+		if (!belowHighSacked(holeCursor)) {
+			break;
+		}
+		retransmit(holeCursor);
+		rexmitted.set(holeCursor);
+		rexmitCount++;
+		holeCursor = seqSpace.next(holeCursor);
+	}
+	transmit();
+}
+
+void TCPRdtSender::setCwndObserver(const CwndObserver &fn)
+{
+	observer = fn;
+	notifyCwnd();
+}
+
+void TCPRdtSender::notifyCwnd()
+{
+	TRACE("cwnd = %.2f, ssthresh = %d%s\n", cwnd, ssthresh,
+	      inRecovery ? " (fast recovery)" : "");
+	if (observer) {
+		observer(cwnd, ssthresh);
+	}
+}
+
 bool TCPRdtSender::getWaitingState()
 {
-	return (nextSeqNum == (base + N) % MAX_SEQ);
+	//超时回退后还有报文没重发完时，先不接收新报文
+	return seqSpace.distance(base, nextSeqNum) >= (uint32_t)N ||
+	       sndNxt != nextSeqNum || pipe() >= window();
+}
+
+void TCPRdtSender::transmit()
+{
+	while (sndNxt != nextSeqNum && pipe() < window()) {
+		if (sackEnabled) {
+			//超时回退时跳过已被SACK的报文，highSacked以下的报文重发后计入pipe
+			if (sacked.test(sndNxt)) {
+				sndNxt = seqSpace.next(sndNxt);
+				continue;
+			}
+			if (belowHighSacked(sndNxt)) {
+				rexmitted.set(sndNxt);
+				rexmitCount++;
+			}
+		}
+		pns->sendToNetworkLayer(RECEIVER, pkts[sndNxt]);
+		TRACE_PACKET("sender sent data packet", pkts[sndNxt]);
+		sndNxt = seqSpace.next(sndNxt);
+	}
+}
+
+void TCPRdtSender::retransmit(int seq)
+{
+	//累积确认分不清确认的是哪一次发送，有重传时放弃当前的RTT计时（Karn算法）
+	rtt.cancel();
+	pns->sendToNetworkLayer(RECEIVER, pkts[seq]);
+	TRACE_PACKET("packet resent", pkts[seq]);
+}
+
+void TCPRdtSender::enterLossState()
+{
+	ssthresh = flightSize() / 2;
+	if (ssthresh < 2) {
+		ssthresh = 2;
+	}
+	recover = nextSeqNum;
+}
+
+void TCPRdtSender::restartTimer()
+{
+	if (batching) {
+		timerPending = true;
+		return;
+	}
+	pns->stopTimer(SENDER, 0);
+	if (base != sndNxt) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
+	}
 }
 
 bool TCPRdtSender::send(const Message &message)
@@ -28,69 +204,205 @@ bool TCPRdtSender::send(const Message &message)
 		return false;
 	}
 
-	Packet pkt = makeDataPkt(nextSeqNum, message.data);
-	pkts[nextSeqNum] = pkt;
-	pns->sendToNetworkLayer(RECEIVER, pkt);
-	pUtils->printPacket("sender sent data packet", pkt);
+	pkts[nextSeqNum] = makeDataPkt(nextSeqNum, message.data);
+	rtt.onSend(nextSeqNum);
+	nextSeqNum = seqSpace.next(nextSeqNum);
 
-	nextSeqNum = (nextSeqNum + 1) % MAX_SEQ;
-	if (nextSeqNum == ((base + 1) % MAX_SEQ)) {
-		pns->startTimer(SENDER, Configuration::TIME_OUT, 0);
+	bool idle = (base == sndNxt);
+	transmit();
+	if (idle && base != sndNxt) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
 	}
 
 	return true;
 }
 
+int TCPRdtSender::sendBatch(Span<const Message> messages)
+{
+	if (sndNxt != nextSeqNum) {
+		return 0;
+	}
+	int room = N - (int)seqSpace.distance(base, nextSeqNum);
+	int allowed = window() - pipe();
+	if (allowed < room) {
+		room = allowed;
+	}
+	size_t n = room > 0 ? (size_t)room : 0;
+	if (messages.size() < n) {
+		n = messages.size();
+	}
+	for (size_t i = 0; i < n; i++) {
+		pkts[nextSeqNum] = makeDataPkt(nextSeqNum, messages[i].data);
+		rtt.onSend(nextSeqNum);
+		nextSeqNum = seqSpace.next(nextSeqNum);
+	}
+
+	bool idle = (base == sndNxt);
+	transmit();
+	if (idle && base != sndNxt) {
+		pns->startTimer(SENDER, rtt.timeout(), 0);
+	}
+	return (int)n;
+}
+
+void TCPRdtSender::receiveBatch(Span<const Packet> ackPkts)
+{
+	batching = true;
+	timerPending = false;
+	ackSums.resize(ackPkts.size());
+	checksumBatch(ackPkts.data(), (int)ackPkts.size(), ackSums.data());
+	for (size_t i = 0; i < ackPkts.size(); i++) {
+		processAck(ackPkts[i], ackSums[i]);
+	}
+	batching = false;
+	if (timerPending) {
+		restartTimer();
+	}
+}
+
 void TCPRdtSender::receive(const Packet &ackPkt)
 {
-	printf("---------------------------------------------------------------\n");
-	printf("sender window:\n");
-	for (int i = base; i != nextSeqNum; i = (i + 1) % MAX_SEQ) {
-		printf("%d ", pkts[i].seqnum);
+	processAck(ackPkt, pUtils->calculateCheckSum(ackPkt));
+}
+
+void TCPRdtSender::processAck(const Packet &ackPkt, int checkSum)
+{
+	TRACE("---------------------------------------------------------------\n");
+	TRACE("sender window:\n");
+	if (TRACE_ENABLED) {
+		for (int i = base; i != nextSeqNum; i = seqSpace.next(i)) {
+			TRACE("%d ", pkts[i].seqnum);
+		}
 	}
-	printf("\n");
+	TRACE("\n");
 
-	int checkSum = pUtils->calculateCheckSum(ackPkt);
-	if (checkSum == ackPkt.checksum) {
-		if (base == (ackPkt.acknum + 1) % MAX_SEQ) {
-			cnt++;
-		} else {
-			base = (ackPkt.acknum + 1) % MAX_SEQ;
+	if (checkSum != ackPkt.checksum) {
+		TRACE_PACKET("sender got ACK packet incorrectly", ackPkt);
+		TRACE("---------------------------------------------------------------\n\n");
+		return;
+	}
+	TRACE_PACKET("sender got ACK packet correctly", ackPkt);
+
+	//窗口为空时pkts[base]是上一轮的旧报文，重复ACK不能触发快速重传
+	if (base == seqSpace.next(ackPkt.acknum) && base != sndNxt) {
+		cnt++;
+		if (sackEnabled) {
+			updateScoreboard(base, ackPkt);
+		}
+		if (inRecovery) {
+			if (sackRecovery) {
+				retransmitHoles();
+			} else {
+				//快速恢复中每个重复ACK代表一个报文离开了网络，窗口膨胀一个报文
+				cwnd += 1;
+				notifyCwnd();
+				transmit();
+			}
+		} else if (cnt == DUP_ACK_THRESHOLD &&
+			   !seqSpace.inRange(recover, seqSpace.next(base),
+					     seqSpace.distance(base,
+							       nextSeqNum))) {
+			//recover在base之后说明这些重复ACK属于已经处理过的那次丢包，不再减半窗口
+			enterLossState();
+			inRecovery = true;
+			sackRecovery = sackEnabled && highSacked != base;
+			retransmit(base);
+			TRACE("quick resent attribute to %d same ACK\n",
+			      DUP_ACK_THRESHOLD);
+			if (sackRecovery) {
+				//记分板已经把离开网络的报文从pipe里扣掉了，不需要再膨胀窗口
+				cwnd = ssthresh;
+				notifyCwnd();
+				rexmitted.set(base);
+				rexmitCount++;
+				holeCursor = seqSpace.next(base);
+				retransmitHoles();
+			} else {
+				cwnd = ssthresh + DUP_ACK_THRESHOLD;
+				notifyCwnd();
+				transmit();
+			}
+		}
+	} else if (seqSpace.inRange(ackPkt.acknum, base,
+				    seqSpace.distance(base, nextSeqNum))) {
+		int oldBase = base;
+		uint32_t acked = seqSpace.distance(base, ackPkt.acknum) + 1;
+		if (rtt.isTiming() &&
+		    seqSpace.inRange(rtt.getTimedSeq(), base, acked)) {
+			rtt.onAck();
 		}
-		if (pkts.count(ackPkt.acknum)) {
-			pkts.erase(ackPkt.acknum);
+		rtt.onNewAck();
+		base = seqSpace.next(ackPkt.acknum);
+		if (seqSpace.distance(oldBase, sndNxt) < acked) {
+			//超时回退后，之前在途的报文仍可能被确认，不必再重发
+			sndNxt = base;
 		}
-		pUtils->printPacket("sender got ACK packet correctly", ackPkt);
-		if (base == nextSeqNum) {
-			pns->stopTimer(SENDER, 0);
-			cnt = 0;
+		cnt = 0;
+		if (sackEnabled) {
+			updateScoreboard(oldBase, ackPkt);
+		}
+
+		if (inRecovery) {
+			if (seqSpace.distance(oldBase, recover) <= acked) {
+				//完全确认，退出快速恢复
+				cwnd = ssthresh;
+				inRecovery = false;
+			} else if (!sackRecovery) {
+				//NewReno部分确认：下一个未确认的报文也丢了，立即重传，并收缩膨胀出的窗口
+				retransmit(base);
+				cwnd -= acked;
+				cwnd += 1;
+				if (cwnd < 1) {
+					cwnd = 1;
+				}
+			}
+		} else if (cwnd < ssthresh) {
+			//慢启动，按确认的报文数增长，每个ACK最多增加2个报文
+			cwnd += acked < 2 ? acked : 2;
+		} else {
+			//拥塞避免，每个RTT增加一个报文
+			cwnd += (double)acked / cwnd;
 		}
-		if (cnt == 3) {
-			pns->sendToNetworkLayer(RECEIVER, pkts[base]);
-			cnt = 0;
-			pUtils->printPacket(
-				"quick resent attribute to 3 same ACK",
-				pkts[base]);
+		if (cwnd > N) {
+			cwnd = N;
 		}
-	} else {
-		pUtils->printPacket("sender got ACK packet incorrectly",
-				    ackPkt);
+		notifyCwnd();
+
+		if (inRecovery && sackRecovery) {
+			//部分确认后继续按记分板重传剩下的空洞
+			retransmitHoles();
+		} else {
+			transmit();
+		}
+		restartTimer();
 	}
 
-	printf("---------------------------------------------------------------\n\n");
+	TRACE("---------------------------------------------------------------\n\n");
 }
 
 void TCPRdtSender::timeoutHandler(int seqNum)
 {
-	int n = ((nextSeqNum - base) + MAX_SEQ) % MAX_SEQ;
-	printf("timeout,resend %d packets,seqnum from %d to %d", n, base,
-	       nextSeqNum - 1);
+	TRACE("timeout,resend from seqnum %d, %d packets outstanding\n", base,
+	      flightSize());
 	pns->stopTimer(SENDER, 0);
+	rtt.onTimeout();
 
-	for (int i = base; i != nextSeqNum; i = (i + 1) % MAX_SEQ) {
-		pns->sendToNetworkLayer(RECEIVER, pkts[i]);
-		pUtils->printPacket("packet resent", pkts[i]);
+	//超时后回到慢启动，从base开始按cwnd重新发送
+	enterLossState();
+	cwnd = 1;
+	inRecovery = false;
+	cnt = 0;
+	notifyCwnd();
+	if (sackEnabled) {
+		//之前的重传都认为已经丢失，回退重发时重新计入pipe
+		for (int i = base; i != nextSeqNum; i = seqSpace.next(i)) {
+			rexmitted.clear(i);
+		}
+		rexmitCount = 0;
+		holeCursor = base;
 	}
+	sndNxt = base;
+	transmit();
 
-	pns->startTimer(SENDER, Configuration::TIME_OUT, 0);
+	pns->startTimer(SENDER, rtt.timeout(), 0);
 }
\ No newline at end of file
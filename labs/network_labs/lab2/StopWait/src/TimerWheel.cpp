@@ -0,0 +1,188 @@
+#include "../include/TimerWheel.h"
+#include <math.h>
+
+static const double EPSILON = 1e-9; //底层定时器按整数时长到时，浮点误差不应让报文多等一个时间单位
+
+TimerWheel::TimerWheel()
+	: count(0)
+	, cursor(0)
+	, armed(false)
+	, armedAt(0)
+	, ticks(0)
+	, clock(nullptr)
+	, clockResolved(false)
+{
+	for (int i = 0; i < Configuration::MAX_WINDOW_SIZE; i++) {
+		nodes[i].running = false;
+	}
+	for (int s = 0; s < SLOTS; s++) {
+		heads[s] = tails[s] = NIL;
+	}
+}
+
+double TimerWheel::now()
+{
+	//与RttEstimator相同，第一次用到时再查找时钟
+	if (!clockResolved) {
+		clock = SimClock::of(pns);
+		clockResolved = true;
+	}
+	if (clock) {
+		return clock->now();
+	}
+	//没有时钟时只知道底层定时器下一次什么时候到时，从那时算起不会提前
+	return armed ? armedAt : ticks;
+}
+
+void TimerWheel::link(int slot)
+{
+	//链表按到期时间排序，一圈以后的节点排在本圈之后。到期时间大致随启动先后递增，从末尾往前找插入位置通常一步就到
+	Node &n = nodes[slot];
+	int s = n.tick & (SLOTS - 1);
+	int prev = tails[s];
+	while (prev != NIL && nodes[prev].deadline > n.deadline) {
+		prev = nodes[prev].prev;
+	}
+	int next = prev != NIL ? nodes[prev].next : heads[s];
+	n.running = true;
+	n.prev = prev;
+	n.next = next;
+	if (prev != NIL) {
+		nodes[prev].next = slot;
+	} else {
+		heads[s] = slot;
+	}
+	if (next != NIL) {
+		nodes[next].prev = slot;
+	} else {
+		tails[s] = slot;
+	}
+	count++;
+}
+
+void TimerWheel::unlink(int slot)
+{
+	Node &n = nodes[slot];
+	if (n.prev != NIL) {
+		nodes[n.prev].next = n.next;
+	} else {
+		heads[n.tick & (SLOTS - 1)] = n.next;
+	}
+	if (n.next != NIL) {
+		nodes[n.next].prev = n.prev;
+	} else {
+		tails[n.tick & (SLOTS - 1)] = n.prev;
+	}
+	n.running = false;
+	count--;
+}
+
+void TimerWheel::arm(double at)
+{
+	if (armed) {
+		pns->stopTimer(SENDER, TIMER_ID);
+		armed = false;
+	}
+	double t = now();
+	int delay = 1;
+	if (clock && at - t > 1) {
+		delay = (int)ceil(at - t - EPSILON);
+	}
+	pns->startTimer(SENDER, delay, TIMER_ID);
+	armed = true;
+	armedAt = t + delay;
+}
+
+bool TimerWheel::dueBy(double at) const
+{
+	long last = (long)floor(at + EPSILON);
+	for (long t = cursor; t <= last && t < cursor + SLOTS; t++) {
+		int slot = heads[t & (SLOTS - 1)];
+		if (slot != NIL && nodes[slot].tick == t) {
+			return nodes[slot].deadline <= at + EPSILON; //链表头是本圈最早到期的
+		}
+	}
+	return false;
+}
+
+void TimerWheel::rearm()
+{
+	if (count == 0) {
+		if (armed) {
+			pns->stopTimer(SENDER, TIMER_ID);
+			armed = false;
+		}
+		return;
+	}
+	//从cursor往后找第一个链表头是本圈节点的轮槽；都在一圈以后时先转一圈
+	for (long t = cursor; t < cursor + SLOTS; t++) {
+		int slot = heads[t & (SLOTS - 1)];
+		if (slot != NIL && nodes[slot].tick == t) {
+			cursor = t; //更早的轮槽里没有本圈的节点，下次从这里找起；之后start更早的节点时会把cursor拉回去
+			arm(nodes[slot].deadline);
+			return;
+		}
+	}
+	arm((double)(cursor + SLOTS));
+}
+
+void TimerWheel::start(int id, int timeout)
+{
+	int slot = slotOf(id);
+	if (isRunning(id)) {
+		unlink(slot);
+	}
+	double t = now();
+	if (count == 0) {
+		cursor = (long)floor(t); //轮空闲了很久时不必从上次的位置找起
+	}
+	Node &n = nodes[slot];
+	n.id = id;
+	n.deadline = t + timeout;
+	n.tick = (long)floor(n.deadline);
+	if (n.tick < cursor) {
+		cursor = n.tick; //RTO变小时新节点可能比rearm找到的最早节点还早，cursor之前的轮槽不会再被扫描
+	}
+	link(slot);
+	if (!armed || n.deadline < armedAt) {
+		arm(n.deadline);
+	}
+}
+
+void TimerWheel::stop(int id)
+{
+	if (!isRunning(id)) {
+		return;
+	}
+	double deadline = nodes[id].deadline;
+	unlink(slotOf(id));
+	//底层定时器可能是为这个报文设的：到时前已经没有别的报文到期时改设到剩下的最早到期时间，
+	//否则到时后没有报文到期却记了一次超时。没有时钟时底层定时器本来就每个时间单位到时一次，轮空了才停掉
+	if (count == 0 || (clock && armed && deadline <= armedAt + EPSILON && !dueBy(armedAt))) {
+		rearm();
+	}
+}
+
+void TimerWheel::expire(std::vector<int> &expired)
+{
+	expired.clear();
+	if (armed) {
+		ticks = armedAt;
+		armed = false;
+	}
+	pns->stopTimer(SENDER, TIMER_ID);
+	double t = now();
+	long last = (long)floor(t);
+	long end = last < cursor + SLOTS ? last : cursor + SLOTS - 1;
+	for (long tick = cursor; tick <= end && count > 0; tick++) {
+		int slot = heads[tick & (SLOTS - 1)];
+		while (slot != NIL && nodes[slot].deadline <= t + EPSILON) {
+			int next = nodes[slot].next;
+			expired.push_back(nodes[slot].id);
+			unlink(slot);
+			slot = next;
+		}
+	}
+	cursor = last;
+	rearm();
+}
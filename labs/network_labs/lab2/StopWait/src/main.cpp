@@ -1,44 +1,154 @@
 #include "../include/Global.h"
 #include "../include/RdtSender.h"
 #include "../include/RdtReceiver.h"
-#include "../include/StopWaitRdtSender.h"
-#include "../include/StopWaitRdtReceiver.h"
-#include "../include/GBNRdtSender.h"
-#include "../include/GBNRdtReceiver.h"
-#include "../include/SRRdtSender.h"
-#include "../include/SRRdtReceiver.h"
-#include "../include/TCPRdtSender.h"
-#include "../include/TCPRdtReceiver.h"
+#include "../include/ProtocolRegistry.h"
+#include "../include/Checksum.h"
+#include "../include/Fec.h"
+#ifndef NETSIM_PREBUILT
+#include "../include/NetworkSimulator.h"
+#endif
+#include <unistd.h>
 
-int main()
-{
+//用-DPROJECT=GBN等配置时，生成的程序默认运行同名协议，仍然可以用-p换成别的协议
 #ifdef GBN
-	auto *ps = new GBNRdtSender(4, 3);
-	auto *pr = new GBNRdtReceiver(3);
-	printf("-*- This is GBN -*-\n\n");
+#define DEFAULT_PROTOCOL "GBN"
 #elif SR
-	auto *ps = new SRRdtSender(4, 3);
-	auto *pr = new SRRdtReceiver(4, 3);
-	printf("-*- This is SR -*-\n\n");
+#define DEFAULT_PROTOCOL "SR"
 #elif TCP
-	auto *ps = new TCPRdtSender(4, 3);
-	auto *pr = new TCPRdtReceiver(3);
-	printf("-*- This is TCP -*-\n\n");
+#define DEFAULT_PROTOCOL "TCP"
 #else
-	auto *ps = new StopWaitRdtSender();
-	auto *pr = new StopWaitRdtReceiver();
-	printf("-*- This is StopWait -*-\n\n");
+#define DEFAULT_PROTOCOL "StopWait"
+#endif
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-p protocol] [-w window] [-b seqNumBits] [-k every[:delay]] [-f xor:k|rs:k:r] [-T trace] [input.txt [output.txt]]\n", prog);
+	fprintf(stderr, "  -k  delayed ACKs: acknowledge every k-th in-order packet, or after delay time units\n");
+	fprintf(stderr, "  -f  forward error correction: r parity packets after every k data packets\n");
+	fprintf(stderr, "  -T  record a binary event trace; convert it with trace2pcap\n");
+	fprintf(stderr, "protocols (default %s):\n", DEFAULT_PROTOCOL);
+	ProtocolRegistry::list(stderr);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *protocol = DEFAULT_PROTOCOL;
+	ProtocolOptions options(4, 3);
+	FecConfig fec;
+	bool useFec = false;
+	const char *traceFile = nullptr;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:w:b:k:f:T:h")) != -1) {
+		switch (opt) {
+		case 'p':
+			protocol = optarg;
+			break;
+		case 'w':
+			options.window = atoi(optarg);
+			break;
+		case 'b':
+			options.seqNumBits = atoi(optarg);
+			break;
+		case 'k': {
+			const char *colon = strchr(optarg, ':');
+			options.ack.every = atoi(optarg);
+			if (colon) {
+				options.ack.delay = atoi(colon + 1);
+			}
+			break;
+		}
+		case 'f':
+			if (!parseFec(optarg, fec)) {
+				fprintf(stderr, "bad FEC '%s': use xor:k or rs:k:r with k <= %d, r <= %d\n",
+					optarg, FecConfig::MAX_K, FecConfig::MAX_R);
+				return 1;
+			}
+			useFec = true;
+			break;
+		case 'T':
+			traceFile = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+	if (options.window < 1 || options.window > Configuration::MAX_WINDOW_SIZE ||
+	    options.seqNumBits < 2 || options.seqNumBits > 32) {
+		fprintf(stderr, "window must be in [1, %d] and seqNumBits in [2, 32]\n",
+			Configuration::MAX_WINDOW_SIZE);
+		return 1;
+	}
+	if (options.ack.every > 1 && options.ack.delay < 1) {
+		fprintf(stderr, "delayed ACK timeout must be at least 1\n");
+		return 1;
+	}
+#ifdef NETSIM_PREBUILT
+	//libnetsim.a不会把接收方定时器交给RdtReceiver
+	if (options.ack.every > 1) {
+		fprintf(stderr, "delayed ACKs need the in-tree simulator (NETSIM_PREBUILT=OFF)\n");
+		return 1;
+	}
+	fec.hold = 0;  //FEC解码器也就不能暂存乱序报文，恢复出来的报文直接交给接收方
+	if (traceFile) {
+		fprintf(stderr, "event traces need the in-tree simulator (NETSIM_PREBUILT=OFF)\n");
+		return 1;
+	}
+#endif
+#ifdef RDT_CHECKSUM
+	pUtils = new ChecksumTool(pUtils, RDT_CHECKSUM);  //用Checksum.h中的算法代替pUtils自带的校验和，接收方构造时就会用到，所以在create之前
 #endif
-	// pns->setRunMode(1);  //安静模式
+	int maxWindow = ProtocolRegistry::maxWindow(protocol, options.seqNumBits);
+	if (maxWindow > 0 && options.window > maxWindow) {
+		fprintf(stderr, "%s with %d-bit sequence numbers allows a window of at most %d\n",
+			protocol, options.seqNumBits, maxWindow);
+		return 1;
+	}
+	RdtPair pair;
+	if (!ProtocolRegistry::create(protocol, options, pair)) {
+		fprintf(stderr, "unknown protocol '%s'\n", protocol);
+		usage(argv[0]);
+		return 1;
+	}
+	RdtSender *ps = pair.sender;
+	RdtReceiver *pr = pair.receiver;
+	printf("-*- This is %s -*-\n\n", protocol);
+#ifndef NETSIM_PREBUILT
+	TraceWriter trace;
+	if (traceFile) {
+		if (!trace.open(traceFile)) {
+			perror(traceFile);
+			return 1;
+		}
+		dynamic_cast<NetworkSimulator *>(pns)->setTrace(&trace);  //要在包装FecNetwork之前，记录的是线路上的报文
+	}
+#endif
+	if (useFec) {
+		pns = new FecNetwork(pns, fec);  //在协议和模拟网络环境之间加一层前向纠错
+	}
+#ifdef RDT_QUIET
+	pns->setRunMode(1);  //安静模式，配合大输入文件做大规模测试
+#endif
+	//可以在命令行指定输入、输出文件：./rdt -p GBN -w 8 input.txt output.txt
+	const char *inputFile = argc > optind ? argv[optind] : "/home/peacewang/sources/network/lab2/input.txt";
+	const char *outputFile = argc > optind + 1 ? argv[optind + 1] : "/home/peacewang/sources/network/lab2/output.txt";
 	pns->init();
 	pns->setRtdSender(ps);
 	pns->setRtdReceiver(pr);
-	pns->setInputFile("/home/peacewang/sources/network/lab2/input.txt");
-	pns->setOutputFile("/home/peacewang/sources/network/lab2/output.txt");
+	pns->setInputFile(inputFile);
+	pns->setOutputFile(outputFile);
 	pns->start();
+#ifndef NETSIM_PREBUILT
+	if (trace.isOpen()) {
+		printf("%ld events traced to %s\n", trace.size(), traceFile);
+		trace.close();
+	}
+#endif
 	delete ps;
 	delete pr;
 	delete pUtils; //指向唯一的工具类实例，只在main函数结束前delete
 	delete pns; //指向唯一的模拟网络环境类实例，只在main函数结束前delete
+	pUtils = nullptr;
+	pns = nullptr;
 	return 0;
 }
@@ -0,0 +1,70 @@
+-- Wireshark解析器：显示trace2pcap生成的pcap文件（链路类型USER0）
+-- 用法：wireshark -X lua_script:tools/rdt_trace.lua run.pcap
+-- payload长度不是21字节时按实际长度显示，过滤示例：rdt.event == 1 && rdt.lost
+
+local rdt = Proto("rdt", "RDT simulator event")
+
+local events = { [1] = "SEND", [2] = "ARRIVE", [3] = "TIMEOUT", [4] = "DELIVER" }
+local targets = { [0] = "SENDER", [1] = "RECEIVER" }
+
+local f_event = ProtoField.uint8("rdt.event", "Event", base.DEC, events)
+local f_target = ProtoField.uint8("rdt.target", "Target", base.DEC, targets)
+local f_flags = ProtoField.uint8("rdt.flags", "Flags", base.HEX)
+local f_lost = ProtoField.bool("rdt.lost", "Lost", 8, nil, 0x01)
+local f_corrupted = ProtoField.bool("rdt.corrupted", "Corrupted", 8, nil, 0x02)
+local f_duplicated = ProtoField.bool("rdt.duplicated", "Duplicated", 8, nil, 0x04)
+local f_reordered = ProtoField.bool("rdt.reordered", "Reordered", 8, nil, 0x08)
+local f_timer = ProtoField.int32("rdt.timer", "Timer")
+local f_seq = ProtoField.int32("rdt.seqnum", "Sequence number")
+local f_ack = ProtoField.int32("rdt.acknum", "Acknowledgment number")
+local f_checksum = ProtoField.int32("rdt.checksum", "Checksum", base.DEC)
+local f_payload = ProtoField.bytes("rdt.payload", "Payload")
+
+rdt.fields = { f_event, f_target, f_flags, f_lost, f_corrupted, f_duplicated, f_reordered,
+               f_timer, f_seq, f_ack, f_checksum, f_payload }
+
+function rdt.dissector(buf, pinfo, tree)
+    if buf:len() < 8 then
+        return 0
+    end
+    local event = buf(0, 1):uint()
+    local target = buf(1, 1):uint()
+    pinfo.cols.protocol = "RDT"
+    local t = tree:add(rdt, buf())
+    t:add(f_event, buf(0, 1))
+    t:add(f_target, buf(1, 1))
+    local flags = t:add(f_flags, buf(2, 1))
+    flags:add(f_lost, buf(2, 1))
+    flags:add(f_corrupted, buf(2, 1))
+    flags:add(f_duplicated, buf(2, 1))
+    flags:add(f_reordered, buf(2, 1))
+
+    local name = events[event] or "?"
+    if event == 3 then
+        t:add(f_timer, buf(4, 4))
+        pinfo.cols.info = string.format("%s %s timer %d", name, targets[target] or "?", buf(4, 4):int())
+        return buf:len()
+    end
+    if buf:len() < 20 then
+        return buf:len()
+    end
+    t:add(f_seq, buf(8, 4))
+    t:add(f_ack, buf(12, 4))
+    t:add(f_checksum, buf(16, 4))
+    t:add(f_payload, buf(20))
+    if event == 4 then
+        pinfo.cols.info = string.format("DELIVER %s", buf(20):stringz())
+    else
+        local kind = target == 1 and "data" or "ack"
+        local note = ""
+        local fl = buf(2, 1):uint()
+        if bit.band(fl, 0x01) ~= 0 then note = note .. " [lost]" end
+        if bit.band(fl, 0x02) ~= 0 then note = note .. " [corrupted]" end
+        if bit.band(fl, 0x04) ~= 0 then note = note .. " [duplicated]" end
+        pinfo.cols.info = string.format("%s %s seq=%d ack=%d%s", name, kind,
+                                        buf(8, 4):int(), buf(12, 4):int(), note)
+    end
+    return buf:len()
+end
+
+DissectorTable.get("wtap_encap"):add(wtap.USER0, rdt)
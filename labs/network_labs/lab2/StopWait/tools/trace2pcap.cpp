@@ -0,0 +1,138 @@
+// 把模拟网络环境记录的二进制事件跟踪转换成pcap文件，链路类型为LINKTYPE_USER0（147），用tools/rdt_trace.lua解析
+// 用法：trace2pcap [-u 时间单位微秒] input.trace output.pcap
+// 每个事件一个pcap报文：8字节伪首部（事件、target、flags、保留、定时器编号，大端），
+// 之后是线路格式的报文（WirePacket：序号、确认号、校验和、payload），TIMEOUT事件没有这一部分
+#include "../include/EventTrace.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+static const uint32_t PCAP_MAGIC_NS = 0xa1b23c4d; //时间戳为纳秒
+static const uint32_t LINKTYPE_USER0 = 147;
+static const int PSEUDO_HEADER_SIZE = 8;
+static const size_t READ_BATCH = 4096;
+
+struct PcapFileHeader {
+	uint32_t magic;
+	uint16_t versionMajor;
+	uint16_t versionMinor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t network;
+};
+
+struct PcapRecordHeader {
+	uint32_t sec;
+	uint32_t nsec;
+	uint32_t inclLen;
+	uint32_t origLen;
+};
+
+static void putBe32(unsigned char *p, uint32_t v)
+{
+	p[0] = (unsigned char)(v >> 24);
+	p[1] = (unsigned char)(v >> 16);
+	p[2] = (unsigned char)(v >> 8);
+	p[3] = (unsigned char)v;
+}
+
+int main(int argc, char *argv[])
+{
+	double unitUs = 1000; //与UdpNetwork的默认值相同，一个时间单位为1毫秒
+	int opt;
+	while ((opt = getopt(argc, argv, "u:")) != -1) {
+		switch (opt) {
+		case 'u':
+			unitUs = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-u time-unit-us] input.trace output.pcap\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind != 2 || unitUs <= 0) {
+		fprintf(stderr, "usage: %s [-u time-unit-us] input.trace output.pcap\n",
+			argv[0]);
+		return 1;
+	}
+	FILE *in = fopen(argv[optind], "rb");
+	if (!in) {
+		perror(argv[optind]);
+		return 1;
+	}
+	TraceFileHeader header;
+	if (fread(&header, sizeof(header), 1, in) != 1 ||
+	    memcmp(header.magic, "RDTTRACE", sizeof(header.magic)) != 0 ||
+	    header.version != TraceWriter::VERSION) {
+		fprintf(stderr, "%s: not an RDT trace file\n", argv[optind]);
+		fclose(in);
+		return 1;
+	}
+	if (header.recordSize != sizeof(TraceRecord) ||
+	    header.payloadSize != (uint32_t)Configuration::PAYLOAD_SIZE) {
+		fprintf(stderr, "%s: recorded with %u-byte payloads, this build uses %d (RDT_PAYLOAD_SIZE)\n",
+			argv[optind], header.payloadSize, Configuration::PAYLOAD_SIZE);
+		fclose(in);
+		return 1;
+	}
+	FILE *out = fopen(argv[optind + 1], "wb");
+	if (!out) {
+		perror(argv[optind + 1]);
+		fclose(in);
+		return 1;
+	}
+
+	PcapFileHeader ph;
+	ph.magic = PCAP_MAGIC_NS;
+	ph.versionMajor = 2;
+	ph.versionMinor = 4;
+	ph.thiszone = 0;
+	ph.sigfigs = 0;
+	ph.snaplen = PSEUDO_HEADER_SIZE + WirePacket::SIZE;
+	ph.network = LINKTYPE_USER0;
+	fwrite(&ph, sizeof(ph), 1, out);
+
+	std::vector<TraceRecord> records(READ_BATCH);
+	std::vector<unsigned char> frame(PSEUDO_HEADER_SIZE + WirePacket::SIZE);
+	long counts[5] = { 0 };
+	size_t n;
+	while ((n = fread(records.data(), sizeof(TraceRecord), READ_BATCH, in)) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			const TraceRecord &r = records[i];
+			uint32_t len = PSEUDO_HEADER_SIZE;
+			frame[0] = r.kind;
+			frame[1] = r.target;
+			frame[2] = r.flags;
+			frame[3] = 0;
+			putBe32(&frame[4], (uint32_t)r.timer);
+			if (r.kind != TRACE_TIMEOUT) {
+				memcpy(&frame[PSEUDO_HEADER_SIZE], &r.packet, WirePacket::SIZE);
+				len += WirePacket::SIZE;
+			}
+			double ns = r.time * unitUs * 1000;
+			PcapRecordHeader rh;
+			rh.sec = (uint32_t)(ns / 1e9);
+			rh.nsec = (uint32_t)(ns - rh.sec * 1e9);
+			rh.inclLen = len;
+			rh.origLen = len;
+			fwrite(&rh, sizeof(rh), 1, out);
+			fwrite(frame.data(), 1, len, out);
+			counts[r.kind < 5 ? r.kind : 0]++;
+		}
+	}
+	fclose(in);
+	fclose(out);
+	printf("send %ld, arrive %ld, timeout %ld, deliver %ld",
+	       counts[TRACE_SEND], counts[TRACE_ARRIVE], counts[TRACE_TIMEOUT],
+	       counts[TRACE_DELIVER]);
+	if (counts[0]) {
+		printf(", unknown %ld", counts[0]);
+	}
+	printf("\n");
+	return 0;
+}